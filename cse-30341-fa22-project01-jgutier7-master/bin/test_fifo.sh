@@ -30,7 +30,7 @@ except ValueError:
 if running != 0 or waiting != 0 or finished != 4:
     sys.exit(2)
 
-if not (5.25 <= turnaround <= 6.25):
+if not (4.75 <= turnaround <= 5.75):
     sys.exit(3)
 
 if not (3.00 <= response <= 4.00):
@@ -29,10 +29,10 @@ except ValueError:
 if running != 0 or waiting != 0 or finished != 3:
     sys.exit(2)
 
-if not (4.00 <= turnaround <= 5.00):
+if not (3.50 <= turnaround <= 4.50):
     sys.exit(3)
 
-if not (1.75 <= response <= 2.75):
+if not (1.50 <= response <= 2.50):
     sys.exit(4)
 EOF
 }
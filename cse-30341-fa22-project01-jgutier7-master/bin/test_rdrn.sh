@@ -30,7 +30,7 @@ except ValueError:
 if running != 0 or waiting != 0 or finished != 4:
     sys.exit(2)
 
-if not (8.25 <= turnaround <= 9.25):
+if not (6.75 <= turnaround <= 7.75):
     sys.exit(3)
 
 if not (0.00 <= response <= 1.00):
@@ -29,7 +29,7 @@ except ValueError:
 if running != 0 or waiting != 0 or finished != 3:
     sys.exit(2)
 
-if not (4.75 <= turnaround <= 5.75):
+if not (4.00 <= turnaround <= 5.00):
     sys.exit(3)
 
 if not (0.00 <= response <= 0.75):
@@ -34,7 +34,7 @@ except ValueError:
 if running != 0 or waiting != 0 or finished != 8:
     sys.exit(2)
 
-if not (8.25 <= turnaround <= 9.25):
+if not (7.75 <= turnaround <= 8.75):
     sys.exit(3)
 
 if not (0.25 <= response <= 1.25):
@@ -0,0 +1,52 @@
+/* capture.h: PQSH Job Output Capture */
+
+#ifndef PQSH_CAPTURE_H
+#define PQSH_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+/* Constants */
+
+#define CAPTURE_RING        (1<<16)     /* Default ring buffer (and log tail) bytes per job */
+#define CAPTURE_QUANTUM     (1<<16)     /* Most bytes drained from one job per event batch */
+#define CAPTURE_EVENTS      64          /* Ready pipes handled per drain */
+
+/* Structures */
+
+typedef struct Capture Capture;
+typedef struct Output  Output;
+
+struct Output {
+    pid_t   pid;        /* Process writing to pipe (0 == not launched yet) */
+    int     fd;         /* Read end of pipe (-1 == end of file reached) */
+    int     sink;       /* Write end of pipe until the process is launched (-1 == closed) */
+    int     log;        /* Log file output is spliced into (-1 == ring buffer) */
+    char   *path;       /* Path of log file (NULL == ring buffer) */
+    char   *ring;       /* Most recent output (NULL == nothing read yet) */
+    size_t  bytes;      /* Total bytes captured */
+};
+
+struct Capture {
+    int         fd;         /* epoll instance watching job pipes (-1 == not capturing) */
+    const char *directory;  /* Directory of per-job log files (NULL == ring buffers) */
+    size_t      size;       /* Ring buffer (and log tail) bytes per job (0 == CAPTURE_RING) */
+    size_t      bytes;      /* Total bytes captured from all jobs */
+};
+
+/* Functions */
+
+bool    capture_init(Capture *c);
+void    capture_release(Capture *c);
+Output *capture_open(Capture *c);
+bool    capture_start(Capture *c, Output *o, pid_t pid);
+size_t  capture_read(Capture *c, Output *o, size_t limit);
+size_t  capture_drain(Capture *c);
+void    capture_dump(Capture *c, Output *o, FILE *fs);
+void    capture_close(Output *o);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
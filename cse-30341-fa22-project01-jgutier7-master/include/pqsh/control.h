@@ -0,0 +1,19 @@
+/* control.h: PQSH Control Socket */
+
+#ifndef PQSH_CONTROL_H
+#define PQSH_CONTROL_H
+
+#include <stdbool.h>
+
+/* Constants */
+
+#define CONTROL_BACKLOG     128     /* Pending connections before clients are refused */
+
+/* Functions */
+
+int     control_open(const char *path);
+int     control_connect(const char *path);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
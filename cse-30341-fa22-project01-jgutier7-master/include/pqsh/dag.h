@@ -0,0 +1,51 @@
+/* dag.h: PQSH Job Dependency Graph */
+
+#ifndef PQSH_DAG_H
+#define PQSH_DAG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Constants */
+
+#define DAG_CAPACITY        64      /* Initial number of buckets (power of two) */
+#define DAG_DEFAULT_COST    1.0     /* Estimated run time of commands without history (seconds) */
+#define DAG_CANCELLED       125     /* Exit status of jobs skipped because a dependency failed */
+
+/* Structures */
+
+typedef struct DagNode  DagNode;
+typedef struct Dag      Dag;
+
+struct DagNode {
+    const char     *id;             /* Interned job name (NULL == anonymous) */
+    struct Process *process;        /* Job */
+    DagNode       **after;          /* Jobs this one depends on */
+    size_t          nafter;         /* Number of dependencies */
+    DagNode       **dependents;     /* Jobs that depend on this one */
+    size_t          ndependents;    /* Number of dependents */
+    size_t          pending;        /* Dependencies not finished yet */
+    double          cost;           /* Estimated run time of job (seconds) */
+    double          rank;           /* Estimated run time of longest path from job to end of graph */
+    bool            finished;       /* Whether or not job finished */
+    bool            failed;         /* Whether or not job (or any dependency) failed */
+    DagNode        *next;           /* Next named node in bucket */
+    DagNode        *link;           /* Next node allocated */
+};
+
+struct Dag {
+    DagNode       **buckets;        /* Named nodes by hash of id */
+    size_t          capacity;       /* Number of buckets (power of two) */
+    size_t          size;           /* Number of named nodes */
+    DagNode        *nodes;          /* Every node (for release) */
+};
+
+/* Functions */
+
+DagNode *   dag_find(Dag *d, const char *id);
+DagNode *   dag_add(Dag *d, struct Process *p, const char *id, DagNode **after, size_t nafter, double cost);
+void        dag_release(Dag *d);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,53 @@
+/* event.h: PQSH Event Loop */
+
+#ifndef PQSH_EVENT_H
+#define PQSH_EVENT_H
+
+#include "timestamp.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Structures */
+
+typedef struct EventLoop    EventLoop;
+typedef struct EventWatcher EventWatcher;
+
+typedef void (*EventHandler)(EventLoop *l, int fd, uint32_t events, void *arg);
+
+struct EventWatcher {
+    int             fd;         /* File descriptor being watched */
+    EventHandler    handler;    /* Callback (NULL == unwatched) */
+    void           *arg;        /* Callback argument */
+
+    EventWatcher   *next;       /* Pointer to next watcher */
+};
+
+struct EventLoop {
+    int             fd;         /* epoll file descriptor */
+    bool            running;    /* Whether or not loop should keep running */
+    EventWatcher   *watchers;   /* List of active watchers */
+    EventWatcher   *garbage;    /* List of unwatched watchers to release */
+    EventHandler    idle;       /* Callback after each batch of events (NULL == none) */
+    void           *idle_arg;   /* Idle callback argument */
+};
+
+/* Functions */
+
+bool    event_loop_init(EventLoop *l);
+bool    event_loop_watch(EventLoop *l, int fd, uint32_t events, EventHandler handler, void *arg);
+bool    event_loop_modify(EventLoop *l, int fd, uint32_t events);
+bool    event_loop_unwatch(EventLoop *l, int fd);
+void    event_loop_idle(EventLoop *l, EventHandler handler, void *arg);
+void    event_loop_run(EventLoop *l);
+void    event_loop_stop(EventLoop *l);
+void    event_loop_release(EventLoop *l);
+
+int     event_timer_open(time_t usec);
+bool    event_timer_set(int fd, time_t usec);
+Time    event_timer_elapsed(int fd);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
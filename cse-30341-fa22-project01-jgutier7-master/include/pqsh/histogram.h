@@ -0,0 +1,40 @@
+/* histogram.h: PQSH Latency Histogram */
+
+#ifndef PQSH_HISTOGRAM_H
+#define PQSH_HISTOGRAM_H
+
+#include "timestamp.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Constants */
+
+#define HISTOGRAM_SUB_BITS  7       /* Sub-buckets per power of two (2^7 == 128, <1.6% error) */
+#define HISTOGRAM_MAX_BITS  50      /* Largest recordable value (2^50 nanoseconds ~ 13 days) */
+
+#define HISTOGRAM_SUB       (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_HALF      (HISTOGRAM_SUB / 2)
+#define HISTOGRAM_BUCKETS   (HISTOGRAM_SUB + (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS) * HISTOGRAM_HALF)
+
+/* Structures */
+
+typedef struct Histogram Histogram;
+
+struct Histogram {
+    uint64_t    counts[HISTOGRAM_BUCKETS];  /* Log-linear buckets of nanoseconds */
+    uint64_t    count;                      /* Number of recorded values */
+    Time        sum;                        /* Sum of recorded values */
+    Time        max;                        /* Largest recorded value */
+};
+
+/* Functions */
+
+void    histogram_record(Histogram *h, Time value);
+Time    histogram_percentile(const Histogram *h, double percentile);
+Time    histogram_mean(const Histogram *h);
+void    histogram_decay(Histogram *h);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
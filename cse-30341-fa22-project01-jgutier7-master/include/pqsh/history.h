@@ -0,0 +1,45 @@
+/* history.h: PQSH Runtime History */
+
+#ifndef PQSH_HISTORY_H
+#define PQSH_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Constants */
+
+#define HISTORY_ALPHA       0.5     /* Weight of newest observation */
+#define HISTORY_BUCKETS     64      /* Initial number of hash buckets */
+#define HISTORY_FILE        ".pqsh_history"
+
+/* Structures */
+
+typedef struct HistoryEntry HistoryEntry;
+typedef struct History      History;
+
+struct HistoryEntry {
+    char           *command;    /* Command string (key) */
+    double          estimate;   /* Exponentially weighted runtime (seconds) */
+    size_t          count;      /* Number of observations */
+
+    HistoryEntry   *next;       /* Next entry in bucket */
+};
+
+struct History {
+    HistoryEntry  **buckets;    /* Hash buckets */
+    size_t          capacity;   /* Number of buckets */
+    size_t          size;       /* Number of entries */
+    double          total;      /* Sum of all entry estimates */
+};
+
+/* Functions */
+
+bool    history_load(History *h, const char *path);
+bool    history_save(History *h, const char *path);
+double  history_estimate(History *h, const char *command);
+bool    history_update(History *h, const char *command, double runtime);
+void    history_release(History *h);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
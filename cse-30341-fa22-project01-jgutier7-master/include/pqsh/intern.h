@@ -0,0 +1,35 @@
+/* intern.h: PQSH Interned Strings */
+
+#ifndef PQSH_INTERN_H
+#define PQSH_INTERN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Constants */
+
+#define INTERN_BUCKETS      256     /* Initial number of hash buckets */
+
+/* Structures */
+
+typedef struct InternString InternString;
+
+struct InternString {
+    InternString   *next;       /* Next entry in bucket */
+    uint64_t        hash;       /* Cached hash of string */
+    size_t          refs;       /* Number of outstanding references */
+    char          **argv;       /* Cached argument vector (single allocation, freed with entry) */
+    char            string[];   /* String contents */
+};
+
+/* Functions */
+
+const char *    intern_acquire(const char *s);
+void            intern_release(const char *s);
+InternString *  intern_entry(const char *s);
+size_t          intern_count(void);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,37 @@
+/* journal.h: PQSH Write-Ahead Journal */
+
+#ifndef PQSH_JOURNAL_H
+#define PQSH_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Constants */
+
+#define JOURNAL_BUFFER      (1<<16)     /* Bytes buffered before they are written without waiting for a commit */
+
+/* Structures */
+
+typedef struct Journal Journal;
+
+struct Journal {
+    const char *path;       /* Path of journal (NULL == closed) */
+    int         fd;         /* Append-only file descriptor */
+    char       *buffer;     /* Records not yet written */
+    size_t      size;       /* Bytes in buffer */
+    bool        dirty;      /* Records written but not yet synced */
+    size_t      sequence;   /* Last assigned job sequence number */
+    size_t      commits;    /* Number of syncs */
+    bool        replaying;  /* Whether or not records are being replayed (nothing is appended) */
+};
+
+/* Functions */
+
+bool    journal_open(Journal *j, const char *path, bool truncate);
+bool    journal_append(Journal *j, const char *format, ...) __attribute__((format(printf, 2, 3)));
+bool    journal_commit(Journal *j);
+void    journal_close(Journal *j);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
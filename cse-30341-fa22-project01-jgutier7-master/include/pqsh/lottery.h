@@ -0,0 +1,35 @@
+/* lottery.h: PQSH Lottery */
+
+#ifndef PQSH_LOTTERY_H
+#define PQSH_LOTTERY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Constants */
+
+#define LOTTERY_CAPACITY    64      /* Initial number of entries */
+
+/* Structures */
+
+typedef struct Lottery Lottery;
+
+struct Lottery {
+    struct Process **entries;   /* Processes holding tickets (dense, in no particular order) */
+    size_t     *sums;           /* Fenwick tree of ticket counts by entry (1-indexed) */
+    size_t      capacity;       /* Number of allocated entries */
+    size_t      size;           /* Number of processes holding tickets */
+    size_t      total;          /* Total number of tickets held */
+};
+
+/* Functions */
+
+bool            lottery_insert(Lottery *l, struct Process *p);
+void            lottery_remove(Lottery *l, struct Process *p);
+bool            lottery_contains(const Lottery *l, const struct Process *p);
+struct Process *lottery_draw(const Lottery *l, size_t ticket);
+void            lottery_release(Lottery *l);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -3,6 +3,7 @@
 #ifndef PQSH_MACROS_H
 #define PQSH_MACROS_H
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,8 +26,12 @@
 
 /* Utilities */
 
+#define container_of(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+
 #define chomp(s)            if (strlen(s)) { s[strlen(s) - 1] = 0; }
 #define min(a, b)           ((a) < (b) ? (a) : (b))
+#define max(a, b)           ((a) > (b) ? (a) : (b))
 #define streq(a, b)         (strcmp(a, b) == 0)
 
 #endif
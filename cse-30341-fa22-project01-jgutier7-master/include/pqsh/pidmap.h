@@ -0,0 +1,39 @@
+/* pidmap.h: PQSH Process Identifier Index */
+
+#ifndef PQSH_PIDMAP_H
+#define PQSH_PIDMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Constants */
+
+#define PIDMAP_CAPACITY     64      /* Initial number of slots (power of two) */
+
+/* Structures */
+
+typedef struct PidEntry PidEntry;
+typedef struct PidMap   PidMap;
+
+struct PidEntry {
+    pid_t       pid;        /* Process identifier (0 == empty) */
+    struct Process *process; /* Process with identifier */
+};
+
+struct PidMap {
+    PidEntry   *entries;    /* Open addressed slots */
+    size_t      capacity;   /* Number of slots (power of two) */
+    size_t      size;       /* Number of occupied slots */
+};
+
+/* Functions */
+
+bool            pidmap_insert(PidMap *m, pid_t pid, struct Process *p);
+struct Process *pidmap_find(PidMap *m, pid_t pid);
+struct Process *pidmap_remove(PidMap *m, pid_t pid);
+void            pidmap_release(PidMap *m);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -3,6 +3,9 @@
 #ifndef PQSH_PROCESS_H
 #define PQSH_PROCESS_H
 
+#include "rbtree.h"
+#include "timestamp.h"
+
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,27 +13,80 @@
 /* Constants */
 
 #define MAX_ARGUMENTS   1024
+#define TICKETS_DEFAULT 100     /* Lottery and stride tickets of a job added without -t */
+
+typedef enum {
+    LAUNCH_FORK,        /* fork and execvp */
+    LAUNCH_VFORK,       /* vfork (clone with CLONE_VM | CLONE_VFORK) and execvp */
+    LAUNCH_SPAWN,       /* posix_spawnp */
+    LAUNCH_SIMULATE,    /* No process (pids are assigned sequentially for a simulator) */
+} LaunchMode;
 
 /* Structure */
 
 typedef struct Process      Process;
+typedef struct Queue        Queue;
 
 struct Process {
-    char    command[BUFSIZ];    /* Command to execute */
+    /* Hot: touched by the scheduler on every tick (fits in one cache line) */
     pid_t   pid;                /* Process identifier (0 == invalid) */
-    double  arrival_time;       /* Process arrival time (is placed into waiting queue) */
-    double  start_time;         /* Process start time (is first placed into running queue) */
-    double  end_time;           /* Process end time (is placed into finished queue) */
-
+    int     core;               /* Scheduler core process last ran on (-1 == none) */
+    int     cpu;                /* CPU to pin process to (-1 == any) */
     Process *next;              /* Pointer to next process */
+    Process *prev;              /* Pointer to previous process */
+    Queue   *queue;             /* Queue containing process (NULL == none) */
+    Time    dispatch_time;      /* Time process was last placed into running queue */
+    Time    run_time;           /* Total time spent in running queue */
+
+    /* Policy: only touched by the policy that uses them */
+    Time    estimate;           /* SRTF predicted total run time */
+    Time    deadline;           /* EDF absolute deadline (0 == none) */
+    struct Tenant *tenant;      /* Fair share tenant job belongs to (NULL == none) */
+    size_t  level;              /* MLFQ priority level (0 == highest) */
+    Time    vruntime;           /* CFS virtual runtime (time / weight) */
+    double  weight;             /* CFS share weight (default 1) */
+    size_t  tickets;            /* Lottery and stride share (default TICKETS_DEFAULT) */
+    size_t  entry;              /* Index in lottery (valid only while holding tickets) */
+    Time    pass;               /* Stride virtual time (run time scaled by TICKETS_DEFAULT / tickets) */
+    RBNode  node;               /* Node in ordered waiting tree */
+
+    /* Cold: only needed at launch, reaping, and reporting */
+    const char *command;        /* Command to execute (interned) */
+    char  **argv;               /* Argument vector parsed from command (shared by interned command) */
+    Time    arrival_time;       /* Process arrival time (is placed into waiting queue) */
+    Time    start_time;         /* Process start time (is first placed into running queue, 0 == never) */
+    Time    end_time;           /* Process end time (is placed into finished queue, 0 == never) */
+    int     status;             /* Wait status once finished */
+    void   *data;               /* Owner data (e.g. simulated workload) */
+    struct DagNode *dag;        /* Node in job dependency graph (NULL == none) */
+    size_t  sequence;           /* Journal sequence number (0 == not journaled) */
+    struct Output *output;      /* Captured stdout and stderr (NULL == inherited from shell) */
+
+    Time    user_time;          /* CPU time in user mode */
+    Time    system_time;        /* CPU time in kernel mode */
+    long    max_rss;            /* Maximum resident set size (KB) */
+    size_t  rss;                /* Resident set size at last sample (bytes) */
+    Time    cpu_time;           /* User plus system time at last sample */
+    char    state;              /* Scheduling state at last sample (R, S, D, ...; 0 == unknown) */
+    long    voluntary_switches;     /* Context switches while waiting on resources */
+    long    involuntary_switches;   /* Context switches due to preemption */
+    Time    stop_time;          /* Time SIGSTOP was sent while instrumenting (0 == no stop pending) */
 };
 
 /* Functions */
 
+char **     process_parse(const char *command);
 Process *   process_create(const char *command);
+void        process_delete(Process *p);
 bool        process_start(Process *p);
+bool        process_launch(Process *p, LaunchMode mode);
+bool        process_launch_mode(const char *name, LaunchMode *mode);
 bool        process_pause(Process *p);
 bool        process_resume(Process *p);
+void        process_dump_header(FILE *fs);
+void        process_dump(Process *p, FILE *fs);
+size_t      process_count(void);
+void        process_trim(void);
 
 #endif
 
@@ -0,0 +1,26 @@
+/* procfs.h: PQSH Linux /proc Readers */
+
+#ifndef PQSH_PROCFS_H
+#define PQSH_PROCFS_H
+
+#include "timestamp.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Constants */
+
+#define PROCFS_ROOT     "/proc"
+
+/* Functions */
+
+bool    procfs_pressure(const char *resource, Time *stalled);
+bool    procfs_available(size_t *bytes);
+bool    procfs_statm(pid_t pid, size_t *rss);
+bool    procfs_stat(pid_t pid, char *state, Time *cpu_time);
+bool    procfs_switches(pid_t pid, long *voluntary, long *involuntary);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
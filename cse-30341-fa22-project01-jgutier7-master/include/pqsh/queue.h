@@ -9,8 +9,6 @@
 
 /* Structure */
 
-typedef struct Queue Queue;
-
 struct Queue {
     Process *head;  /* Head of queue */
     Process *tail;  /* Tail of queue */
@@ -20,8 +18,10 @@ struct Queue {
 /* Functions */
 
 void        queue_push(Queue *q, Process *p);
+void        queue_insert(Queue *q, Process *p, Process *before);
 Process *   queue_pop(Queue *q);
 Process *   queue_remove(Queue *q, pid_t pid);
+void        queue_unlink(Process *p);
 void        queue_dump(Queue *q, FILE *fs);
 
 #endif
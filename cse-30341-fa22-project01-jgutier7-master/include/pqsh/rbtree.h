@@ -0,0 +1,39 @@
+/* rbtree.h: PQSH Red-Black Tree */
+
+#ifndef PQSH_RBTREE_H
+#define PQSH_RBTREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Structures */
+
+typedef struct RBNode RBNode;
+typedef struct RBTree RBTree;
+
+typedef int (*RBCompare)(const RBNode *a, const RBNode *b);
+
+struct RBNode {
+    RBNode  *parent;    /* Parent node (NULL == root) */
+    RBNode  *left;      /* Left child */
+    RBNode  *right;     /* Right child */
+    bool     red;       /* Node color */
+};
+
+struct RBTree {
+    RBNode  *root;      /* Root of tree */
+    RBNode  *first;     /* Cached leftmost (minimum) node */
+    size_t   size;      /* Number of nodes in tree */
+};
+
+/* Functions */
+
+void        rbtree_insert(RBTree *t, RBNode *n, RBCompare compare);
+void        rbtree_remove(RBTree *t, RBNode *n);
+RBNode *    rbtree_first(RBTree *t);
+RBNode *    rbtree_last(RBTree *t);
+RBNode *    rbtree_next(RBNode *n);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -3,55 +3,251 @@
 #ifndef PQSH_SCHEDULER_H
 #define PQSH_SCHEDULER_H
 
+#include "capture.h"
+#include "dag.h"
+#include "histogram.h"
+#include "history.h"
+#include "journal.h"
+#include "lottery.h"
+#include "pidmap.h"
 #include "queue.h"
+#include "trace.h"
 
 #include <stdio.h>
+#include <sys/resource.h>
 
 /* Constants */
 
 typedef enum {
     FIFO_POLICY,        /* First in, first out */
     RDRN_POLICY,        /* Round robin */
+    MLFQ_POLICY,        /* Multi-level feedback queue */
+    CFS_POLICY,         /* Completely fair (virtual runtime) */
+    SRTF_POLICY,        /* Shortest remaining time first */
+    LOTTERY_POLICY,     /* Proportional share by random ticket draw */
+    STRIDE_POLICY,      /* Proportional share by ticket-scaled virtual time */
+    EDF_POLICY,         /* Earliest deadline first */
+    FAIR_POLICY,        /* Weighted fair share of cores among tenants */
 } Policy;
 
+#define MLFQ_MAX_LEVELS 8   /* Maximum number of MLFQ priority levels */
+
+#define TENANT_DEFAULT  "default"   /* Tenant of jobs added without --tenant (fair) */
+
+#define LOTTERY_SEED    UINT64_C(0x9e3779b97f4a7c15)   /* Default lottery random state */
+
+#define SLICE_MIN           1000    /* Smallest adaptive time slice (microseconds) */
+#define SLICE_SAMPLES       32      /* Finished processes needed before bursts are trusted */
+#define SLICE_WINDOW        1024    /* Bursts remembered before older ones decay */
+#define SLICE_PERCENTILE    80      /* Percentage of bursts that should fit in one slice */
+
+#define STOP_LIMIT          (10 * NSEC_PER_MSEC)    /* Longest stop latency before a pause counts as a timeout (-I) */
+#define SHUTDOWN_LIMIT      NSEC_PER_SEC            /* Time jobs get to exit after SIGTERM at shutdown */
+
+#define ADMIT_PERIOD        (NSEC_PER_SEC / 4)  /* Time between pressure samples */
+#define ADMIT_SCALE         4       /* Most processes per core when jobs are I/O bound */
+#define ADMIT_IDLE          0.75    /* Fraction of cores jobs must use before the limit stops growing */
+#define ADMIT_CPU_PRESSURE  0.10    /* CPU pressure that shrinks a raised limit */
+#define ADMIT_HEADROOM      2       /* Available memory needed to start a job (multiple of job RSS) */
+
 enum {
     RUNNING  = 1<<0,    /* Running queue */
     WAITING  = 1<<1,    /* Waiting queue */
     FINISHED = 1<<2,    /* Finished queue */
+    STATS    = 1<<3,    /* Resource usage and latency percentiles */
 };
 
 /* Structure */
 
+typedef struct Tenant    Tenant;
 typedef struct Scheduler Scheduler;
 
+struct Tenant {
+    const char *name;       /* Tenant name (interned) */
+    double      weight;     /* Share of cores relative to other tenants (default 1) */
+    Policy      policy;     /* Policy among the tenant's jobs (fifo or rdrn) */
+    Queue       waiting;    /* Waiting jobs of tenant */
+    size_t      running;    /* Running jobs at last schedule */
+    Time        vruntime;   /* Core time received per unit of weight */
+    size_t      finished;   /* Finished jobs */
+    Time        run_time;   /* Core time of finished jobs */
+};
+
 struct Scheduler {
     Policy  policy;     /* Scheduling policy */
     size_t  cores;      /* Number of CPU cores to utilize */
     time_t  timeout;    /* Time slice (microseconds) */
+    LaunchMode launch;  /* Process launch mechanism */
 
     Queue   running;    /* Queue of running processes */
     Queue   waiting;    /* Queue of waiting processes */
     Queue   finished;   /* Queue of finished processes */
+    PidMap  pids;       /* Launched, unreaped processes by pid */
+
+    /* Multi-level feedback queue */
+    size_t  levels;                     /* Number of priority levels */
+    time_t  boost;                      /* Priority boost period (microseconds) */
+    Time    last_boost;                 /* Time of last priority boost */
+    Queue   level[MLFQ_MAX_LEVELS];     /* Waiting processes per priority level */
+
+    /* Completely fair */
+    RBTree  tree;                       /* Waiting processes ordered by policy key */
+    Time    min_vruntime;               /* Monotonic minimum virtual runtime */
+
+    /* Proportional share (lottery and stride; stride waits in tree) */
+    Lottery     lottery;                /* Waiting processes by tickets */
+    uint64_t    seed;                   /* Lottery random state (0 == LOTTERY_SEED) */
+    Time        global_pass;            /* Monotonic minimum stride pass */
+
+    /* Tenants (fair) */
+    Tenant    **tenants;                /* Tenants by order of first use */
+    size_t      ntenants;               /* Number of tenants */
+    Time        tenant_time;            /* Time tenants were last charged (0 == never) */
+    Time        min_tenant_vruntime;    /* Monotonic minimum virtual runtime of active tenants */
+
+    /* Shortest remaining time first */
+    History     history;                /* Learned run time estimates by command */
+    const char *history_path;           /* Path to persisted history (NULL == none) */
+
+    /* Adaptive time slice (round robin) */
+    double      overhead;               /* Target preemption overhead (fraction, 0 == fixed timeout) */
+    Time        switch_cost;            /* Smoothed cost of a preempting timer interrupt */
+    time_t      slice;                  /* Current time slice (microseconds, at most timeout) */
+    Histogram   bursts;                 /* Recent CPU time of finished processes */
+    Time        burst;                  /* SLICE_PERCENTILE of bursts (0 == too few samples) */
+
+    /* Preemption cost */
+    bool        instrument;             /* Time pauses and resumes and sample context switches */
+    Histogram   stop_latency;           /* SIGSTOP until the stop is reported by SIGCHLD */
+    Histogram   resume_latency;         /* Re-pinning and SIGCONT of a paused process */
+    size_t      stop_timeouts;          /* Pauses not reported stopped within STOP_LIMIT or before resuming */
+    size_t      dispatches;             /* Number of times a process was placed into running queue */
+    long        voluntary_switches;     /* Context switches of processes at their last sample */
+    long        involuntary_switches;   /* Involuntary context switches of processes at their last sample */
+
+    /* Sleeping processes (round robin) */
+    bool        swap_sleeping;          /* Swap sleeping running processes for waiting ones */
+    size_t      sleep_swaps;            /* Number of processes swapped out while sleeping */
+
+    /* Cores */
+    Process   **slots;                  /* Process running on each core (NULL == idle) */
+    Queue      *runqueues;              /* Waiting processes per core (affinity only) */
+    bool        affinity;               /* Pin cores to CPUs with per-core run queues */
+    int        *cpus;                   /* CPUs available for pinning */
+    size_t      ncpus;                  /* Number of CPUs available for pinning */
+
+    /* Admission control (fifo) */
+    size_t      limit;                  /* Processes allowed to run at once (cores unless adjusted) */
+    double      memory_limit;           /* Memory pressure that holds waiting jobs (fraction, 0 == off) */
+    Time        admit_time;             /* Time of last pressure sample (0 == none) */
+    Time        memory_stall;           /* PSI memory stall total at last sample */
+    Time        cpu_stall;              /* PSI cpu stall total at last sample */
+    double      memory_pressure;        /* Fraction of last period some task stalled on memory */
+    double      cpu_pressure;           /* Fraction of last period some task waited for a CPU */
+    double      usage;                  /* CPUs used by running jobs over last period */
+    size_t      job_rss;                /* Smoothed resident set of running jobs (bytes) */
+    size_t      holds;                  /* Samples that held waiting jobs */
+
+    /* Dependencies */
+    Dag         dag;                    /* Jobs added with --id or --after */
+    Queue       blocked;                /* Jobs whose dependencies have not finished */
+
+    /* Crash recovery */
+    Journal     journal;                /* Write-ahead journal of submissions and exits */
+    const char *journal_path;           /* Path of journal (NULL == none) */
+
+    /* Batch */
+    const char *batch_path;             /* Job file to run to completion (NULL == interactive, "-" == stdin) */
+    const char *socket_path;            /* UNIX socket accepting commands from clients (NULL == none) */
+
+    /* Job output */
+    Capture     capture;                /* Stdout and stderr of launched jobs (no directory or size == inherited) */
 
     /* Total turnaround and response time */
-    double  total_turnaround_time;
-    double  total_response_time;
+    Time    total_turnaround_time;
+    Time    total_response_time;
+    size_t  preemptions;                /* Number of times a running process was paused */
+
+    /* Latency distributions (nanoseconds) */
+    Histogram   turnaround;             /* Arrival to exit */
+    Histogram   response;               /* Arrival to first start */
+    Histogram   wait;                   /* Time runnable but not running */
+    Histogram   lateness;               /* Finish past deadline (0 when met) */
+    size_t      deadlines;              /* Finished processes with a deadline */
+    size_t      deadline_misses;        /* Finished processes past their deadline */
+    const char *metrics_path;           /* Per-job metrics written at exit (NULL == none) */
+
+    /* Timeline */
+    Trace       trace;                  /* Ring buffer of scheduling events */
+    const char *trace_path;             /* Chrome trace written at exit (NULL == none) */
 };
 
 /* Commands */
 
-void    scheduler_add(Scheduler *s, FILE *fs, const char *command);
+Process *scheduler_add(Scheduler *s, FILE *fs, const char *command);
 void    scheduler_status(Scheduler *s, FILE *fs, int queue);
+bool    scheduler_output(Scheduler *s, FILE *fs, pid_t pid);
+void    scheduler_stats(Scheduler *s, FILE *fs);
+bool    scheduler_export(Scheduler *s, const char *path);
 
 /* Functions */
 
+bool    scheduler_init(Scheduler *s);
+void    scheduler_release(Scheduler *s);
+void    scheduler_shutdown(Scheduler *s);
 void    scheduler_next(Scheduler *s);
-void    scheduler_wait(Scheduler *s);
+size_t  scheduler_wait(Scheduler *s);
+size_t  scheduler_waiting(Scheduler *s);
+void    scheduler_exit(Scheduler *s, Process *p, int status, const struct rusage *usage);
+void    scheduler_finish(Scheduler *s, Process *p);
+void    scheduler_ready(Scheduler *s, Process *p);
+void    scheduler_cancel(Scheduler *s, Process *p);
+void    scheduler_unblock(Scheduler *s, DagNode *n, bool failed);
+bool    scheduler_dispatch(Scheduler *s, Process *p);
+Process *scheduler_find(Scheduler *s, pid_t pid);
+bool    scheduler_sleeping(Scheduler *s, Process *p);
+void    scheduler_preempt(Scheduler *s, Process *p);
+
+/* Journal */
+
+void    scheduler_journal_add(Scheduler *s, Process *p);
+void    scheduler_journal_finish(Scheduler *s, Process *p);
+bool    scheduler_recover(Scheduler *s);
+
+/* Adaptive time slice */
+
+void    scheduler_slice_cost(Scheduler *s, Time cost);
+void    scheduler_slice_burst(Scheduler *s, Time burst);
+time_t  scheduler_slice(Scheduler *s);
+
+/* Preemption cost */
+
+void    scheduler_switch_sample(Scheduler *s, Process *p, long voluntary, long involuntary);
+void    scheduler_switch_pause(Scheduler *s, Process *p, Time begin);
+void    scheduler_switch_stopped(Scheduler *s, Process *p, Time now);
+void    scheduler_switch_resume(Scheduler *s, Process *p, Time begin);
+
+/* Tenants */
+
+Tenant *scheduler_tenant(Scheduler *s, const char *name);
+bool    scheduler_tenant_config(Scheduler *s, const char *spec);
+
+/* Admission control */
+
+void    scheduler_admit(Scheduler *s);
+void    scheduler_admit_update(Scheduler *s, double memory, double cpu, double usage, size_t available);
 
 /* Policies */
 
 void    scheduler_fifo(Scheduler *s);
 void    scheduler_rdrn(Scheduler *s);
+void    scheduler_mlfq(Scheduler *s);
+void    scheduler_cfs(Scheduler *s);
+void    scheduler_srtf(Scheduler *s);
+void    scheduler_lottery(Scheduler *s);
+void    scheduler_stride(Scheduler *s);
+void    scheduler_edf(Scheduler *s);
+void    scheduler_fair(Scheduler *s);
 
 #endif
 
@@ -5,6 +5,7 @@
 
 #include <signal.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifndef GNU_SOURCE
 typedef void (*sighandler_t)(int);
@@ -13,10 +14,8 @@ typedef void (*sighandler_t)(int);
 /* Functions */
 
 bool    signal_register(int signum, int flags, sighandler_t handler);
-
-/* Handlers */
-
-void	sigalrm_handler(int signum);
+int     signal_open(int signum);
+size_t  signal_drain(int fd);
 
 #endif
 
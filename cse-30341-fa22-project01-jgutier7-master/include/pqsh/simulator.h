@@ -0,0 +1,58 @@
+/* simulator.h: PQSH Discrete-Event Simulator */
+
+#ifndef PQSH_SIMULATOR_H
+#define PQSH_SIMULATOR_H
+
+#include "rbtree.h"
+#include "scheduler.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Constants */
+
+#define SIMULATOR_EPOCH     1.0     /* Virtual time of trace time 0 (0 means unset to the scheduler) */
+#define SIMULATOR_EPSILON   1e-9    /* Events closer than this are simultaneous */
+
+/* Structures */
+
+typedef struct SimJob    SimJob;
+typedef struct Simulator Simulator;
+
+struct SimJob {
+    /* Workload */
+    double      arrival;    /* Arrival time relative to start of trace (seconds) */
+    double      burst;      /* Total CPU time (seconds) */
+    double      io_period;  /* CPU time between I/O operations (0 == no I/O) */
+    double      io_time;    /* Duration of each I/O operation (seconds) */
+    const char *command;    /* Interned command (determines history key) */
+    size_t      id;         /* Line order in trace (breaks arrival ties) */
+
+    /* State */
+    double      left;       /* CPU time left */
+    double      phase;      /* CPU time left before next I/O */
+    bool        io;         /* Whether or not job is blocked on I/O */
+    double      io_until;   /* Time I/O completes */
+    RBNode      node;       /* Node in I/O tree */
+    Process    *process;    /* Scheduled process (its state follows the job) */
+};
+
+struct Simulator {
+    SimJob     *jobs;       /* Jobs ordered by arrival */
+    size_t      size;       /* Number of jobs */
+    size_t      capacity;   /* Allocated number of jobs */
+    size_t      arrived;    /* Number of jobs added to the scheduler */
+    size_t      finished;   /* Number of jobs completed */
+    RBTree      io;         /* Jobs blocked on I/O ordered by completion */
+    double      now;        /* Time relative to start of trace (seconds) */
+};
+
+/* Functions */
+
+bool    simulator_load(Simulator *sim, FILE *fs);
+bool    simulator_run(Simulator *sim, Scheduler *s);
+void    simulator_release(Simulator *sim);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
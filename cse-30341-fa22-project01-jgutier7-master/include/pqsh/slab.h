@@ -0,0 +1,38 @@
+/* slab.h: PQSH Slab Allocator */
+
+#ifndef PQSH_SLAB_H
+#define PQSH_SLAB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Constants */
+
+#define SLAB_CHUNK          (64 * 1024)     /* Bytes per chunk */
+#define SLAB_ALIGN          16              /* Object alignment */
+
+/* Structures */
+
+typedef struct Slab Slab;
+
+struct Slab {
+    size_t  size;       /* Object size (rounded up to SLAB_ALIGN) */
+    void   *chunks;     /* Singly-linked list of chunks */
+    void   *free;       /* Singly-linked list of free objects */
+    size_t  used;       /* Number of allocated objects */
+    size_t  capacity;   /* Number of objects in all chunks */
+};
+
+#define SLAB_INITIALIZER(type) \
+    { .size = (sizeof(type) + SLAB_ALIGN - 1) & ~(size_t)(SLAB_ALIGN - 1) }
+
+/* Functions */
+
+void *  slab_alloc(Slab *s);
+void    slab_free(Slab *s, void *object);
+bool    slab_trim(Slab *s);
+void    slab_release(Slab *s);
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -3,9 +3,46 @@
 #ifndef PQSH_TIMESTAMP_H
 #define PQSH_TIMESTAMP_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Constants */
+
+#define NSEC_PER_SEC    INT64_C(1000000000)
+#define NSEC_PER_MSEC   INT64_C(1000000)
+#define NSEC_PER_USEC   INT64_C(1000)
+
+#define TIMESTAMP_CALIBRATION   (10 * NSEC_PER_MSEC)     /* TSC calibration period (10 ms) */
+
+/* Types */
+
+typedef int64_t Time;   /* Monotonic timestamp or duration (nanoseconds) */
+
 /* Functions */
 
-double	    timestamp();
+Time	    timestamp();
+void	    timestamp_virtual(Time now);
+bool	    timestamp_tsc();
+double	    timestamp_wall(Time t);
+Time	    timestamp_from_wall(double seconds);
+
+/**
+ * Convert time to seconds.
+ * @param   t           Time (nanoseconds).
+ * @return  Seconds.
+ **/
+static inline double time_to_seconds(Time t) {
+    return (double)t / NSEC_PER_SEC;
+}
+
+/**
+ * Convert seconds to time (rounded to the nearest nanosecond).
+ * @param   seconds     Seconds.
+ * @return  Time (nanoseconds).
+ **/
+static inline Time time_from_seconds(double seconds) {
+    return (Time)(seconds * NSEC_PER_SEC + (seconds < 0 ? -0.5 : 0.5));
+}
 
 #endif
 
@@ -0,0 +1,70 @@
+/* trace.h: PQSH Scheduling Trace */
+
+#ifndef PQSH_TRACE_H
+#define PQSH_TRACE_H
+
+#include "process.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Constants */
+
+#define TRACE_CAPACITY      (1 << 18)   /* Default number of events kept */
+
+typedef enum {
+    TRACE_ARRIVAL,      /* Added to waiting queue */
+    TRACE_START,        /* Launched on core */
+    TRACE_PAUSE,        /* Preempted from core */
+    TRACE_RESUME,       /* Resumed on core */
+    TRACE_EXIT,         /* Reaped (or failed to launch) */
+} TraceType;
+
+/* Structures */
+
+typedef struct TraceEvent TraceEvent;
+typedef struct Trace      Trace;
+
+struct TraceEvent {
+    Time        time;       /* Timestamp */
+    const char *command;    /* Interned command of process */
+    int32_t     pid;        /* Process identifier */
+    int16_t     core;       /* Scheduler core (-1 == none) */
+    uint8_t     type;       /* TraceType */
+};
+
+struct Trace {
+    TraceEvent *events;     /* Ring buffer (NULL == tracing disabled) */
+    size_t      capacity;   /* Number of events in ring buffer */
+    size_t      count;      /* Number of events ever recorded */
+    Time        origin;     /* Time of trace start */
+};
+
+/* Functions */
+
+bool    trace_init(Trace *t, size_t capacity);
+bool    trace_flush(Trace *t, const char *path);
+void    trace_release(Trace *t);
+
+/**
+ * Record scheduling event (oldest events are overwritten once full).
+ * @param   t           Pointer to Trace structure.
+ * @param   type        Type of event.
+ * @param   p           Pointer to Process structure.
+ * @param   core        Scheduler core (-1 == none).
+ * @param   time        Timestamp of event.
+ **/
+static inline void trace_record(Trace *t, TraceType type, const Process *p, int core, Time time) {
+    if (t->events) {
+        TraceEvent *e = &t->events[t->count++ % t->capacity];
+        e->time    = time;
+        e->command = p->command;
+        e->pid     = p->pid;
+        e->core    = core;
+        e->type    = type;
+    }
+}
+
+#endif
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,254 @@
+/* capture.c: PQSH Job Output Capture */
+
+#define _GNU_SOURCE
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/capture.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+
+/**
+ * Prepare to capture job output, creating the log directory if needed.
+ * @param   c           Pointer to Capture structure.
+ * @return  Whether or not output can be captured.
+ **/
+bool capture_init(Capture *c) {
+    if (c->directory && mkdir(c->directory, 0755) < 0 && errno != EEXIST) {
+        error("Unable to create output directory %s: %s", c->directory, strerror(errno));
+        return false;
+    }
+
+    c->fd = epoll_create1(EPOLL_CLOEXEC);
+    if (c->fd < 0) {
+        error("Unable to epoll_create1: %s", strerror(errno));
+        return false;
+    }
+    if (!c->size) {
+        c->size = CAPTURE_RING;
+    }
+    return true;
+}
+
+/**
+ * Stop capturing output (pipes are closed with their processes).
+ * @param   c           Pointer to Capture structure.
+ **/
+void capture_release(Capture *c) {
+    if (c->fd >= 0) {
+        close(c->fd);
+    }
+    c->fd = -1;
+}
+
+/**
+ * Create pipe for the output of a process about to be launched.
+ *
+ * Both ends are closed on exec, so a job only holds its own pipe (once it is
+ * duplicated onto stdout and stderr) and end of file arrives when it exits.
+ * Only the read end is nonblocking: jobs writing faster than they are drained
+ * block on a full pipe rather than losing output.
+ *
+ * @param   c           Pointer to Capture structure.
+ * @return  Pointer to new Output (NULL on error).
+ **/
+Output *capture_open(Capture *c) {
+    int fds[2];
+
+    Output *o = calloc(1, sizeof(Output));
+    if (!o) {
+        return NULL;
+    }
+    if (pipe2(fds, O_CLOEXEC) < 0) {
+        error("Unable to create pipe: %s", strerror(errno));
+        free(o);
+        return NULL;
+    }
+
+    o->fd   = fds[0];
+    o->sink = fds[1];
+    o->log  = -1;
+    if (fcntl(o->fd, F_SETFL, O_NONBLOCK) < 0) {
+        error("Unable to make pipe nonblocking: %s", strerror(errno));
+        capture_close(o);
+        return NULL;
+    }
+    return o;
+}
+
+/**
+ * Start capturing output of launched process: close the parent's copy of the
+ * write end, create the process's log file, and watch the read end.
+ *
+ * Log files are named DIRECTORY/PID-START.log, where START is the wall clock
+ * time of launch (seconds.nanoseconds), so a job whose pid was used before
+ * gets its own log. The file is created exclusively and never truncated; if
+ * it cannot be created, output is kept in a ring buffer instead.
+ *
+ * @param   c           Pointer to Capture structure.
+ * @param   o           Pointer to Output of process.
+ * @param   pid         Process identifier.
+ * @return  Whether or not the pipe is being watched.
+ **/
+bool capture_start(Capture *c, Output *o, pid_t pid) {
+    close(o->sink);
+    o->sink = -1;
+    o->pid  = pid;
+
+    if (c->directory) {
+        char            path[BUFSIZ];
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        snprintf(path, BUFSIZ, "%s/%d-%ld.%09ld.log", c->directory, pid, (long)now.tv_sec, now.tv_nsec);
+        o->log = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (o->log < 0) {
+            error("Unable to create %s: %s", path, strerror(errno));
+        } else if (!(o->path = strdup(path))) {
+            close(o->log);                                          // output goes to the ring buffer
+            o->log = -1;
+            unlink(path);
+        }
+    }
+
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = o };
+    if (epoll_ctl(c->fd, EPOLL_CTL_ADD, o->fd, &event) < 0) {
+        error("Unable to watch output of process %d: %s", pid, strerror(errno));
+        close(o->fd);                                               // writes fail rather than block forever
+        o->fd = -1;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Move available output of process into its log file or ring buffer.
+ *
+ * Log files are filled with splice, which moves pipe pages into the page
+ * cache without copying them through user space. Ring buffers (allocated on
+ * the first byte of output) are read into directly, keeping only the most
+ * recent bytes. Reaching end of file closes the pipe, which also removes it
+ * from the epoll instance.
+ *
+ * @param   c           Pointer to Capture structure.
+ * @param   o           Pointer to Output of process.
+ * @param   limit       Most bytes to move (bounds time spent on a chatty job).
+ * @return  Number of bytes moved.
+ **/
+size_t capture_read(Capture *c, Output *o, size_t limit) {
+    size_t  moved = 0;
+    ssize_t n;
+
+    while (o->fd >= 0 && moved < limit) {
+        if (o->log >= 0) {
+            n = splice(o->fd, NULL, o->log, NULL, limit - moved, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        } else if (!o->ring && !(o->ring = malloc(c->size))) {
+            n = -1;
+            errno = ENOMEM;
+        } else {
+            size_t head = o->bytes % c->size;
+            n = read(o->fd, o->ring + head, min(c->size - head, limit - moved));
+        }
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            break;
+        }
+        if (n <= 0) {                                               // end of file (or unrecoverable error)
+            if (n < 0) {
+                error("Unable to capture output of process %d: %s", o->pid, strerror(errno));
+            }
+            close(o->fd);
+            o->fd = -1;
+            if (o->log >= 0) {
+                close(o->log);
+                o->log = -1;
+            }
+            break;
+        }
+        moved    += n;
+        o->bytes += n;
+    }
+
+    c->bytes += moved;
+    return moved;
+}
+
+/**
+ * Drain pipes that are ready, at most CAPTURE_QUANTUM bytes each, so a job
+ * flooding its pipe cannot hold up the event loop (the rest is left for the
+ * next batch, and the job blocks once its pipe is full).
+ * @param   c           Pointer to Capture structure.
+ * @return  Number of bytes moved.
+ **/
+size_t capture_drain(Capture *c) {
+    struct epoll_event events[CAPTURE_EVENTS];
+    size_t moved = 0;
+
+    int ready = epoll_wait(c->fd, events, CAPTURE_EVENTS, 0);
+    for (int i = 0; i < ready; i++) {
+        moved += capture_read(c, events[i].data.ptr, CAPTURE_QUANTUM);
+    }
+    return moved;
+}
+
+/**
+ * Write most recent output of process (at most the ring size) to stream.
+ * @param   c           Pointer to Capture structure.
+ * @param   o           Pointer to Output of process.
+ * @param   fs          Output file stream.
+ **/
+void capture_dump(Capture *c, Output *o, FILE *fs) {
+    if (o->ring) {
+        size_t held  = min(o->bytes, c->size);
+        size_t start = (o->bytes - held) % c->size;
+        size_t first = min(held, c->size - start);
+        fwrite(o->ring + start, 1, first, fs);
+        fwrite(o->ring, 1, held - first, fs);
+        return;
+    }
+    if (!o->path) {
+        return;
+    }
+
+    /* Tail of log file */
+    int fd = open(o->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    char        buffer[BUFSIZ];
+    struct stat st;
+    ssize_t     n;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size > c->size) {
+        lseek(fd, st.st_size - c->size, SEEK_SET);
+    }
+    while ((n = read(fd, buffer, BUFSIZ)) > 0) {
+        fwrite(buffer, 1, n, fs);
+    }
+    close(fd);
+}
+
+/**
+ * Close pipe and log file of process and release its output.
+ * @param   o           Pointer to Output (NULL == none).
+ **/
+void capture_close(Output *o) {
+    if (!o) {
+        return;
+    }
+    if (o->fd >= 0)   close(o->fd);
+    if (o->sink >= 0) close(o->sink);
+    if (o->log >= 0)  close(o->log);
+    free(o->path);
+    free(o->ring);
+    free(o);
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
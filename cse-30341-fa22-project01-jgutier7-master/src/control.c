@@ -0,0 +1,89 @@
+/* control.c: PQSH Control Socket */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/control.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * Fill UNIX domain socket address.
+ * @param   addr        Pointer to sockaddr_un structure.
+ * @param   path        Path of socket.
+ * @return  Whether or not the path fits.
+ **/
+static bool control_address(struct sockaddr_un *addr, const char *path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        error("Socket path too long: %s", path);
+        return false;
+    }
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+/**
+ * Listen for local clients on a UNIX domain socket.
+ *
+ * A socket left behind by a previous shell is replaced, but one that still
+ * accepts connections belongs to a running shell and is left alone.
+ *
+ * @param   path        Path of socket.
+ * @return  Non-blocking listening file descriptor (-1 on failure).
+ **/
+int control_open(const char *path) {
+    struct sockaddr_un addr;
+    if (!control_address(&addr, path)) {
+        return -1;
+    }
+
+    int existing = control_connect(path);
+    if (existing >= 0) {
+        close(existing);
+        error("Socket %s is already in use", path);
+        return -1;
+    }
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        error("Unable to socket: %s", strerror(errno));
+        return -1;
+    }
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, CONTROL_BACKLOG) < 0) {
+        error("Unable to listen on %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Connect to shell listening on a UNIX domain socket.
+ * @param   path        Path of socket.
+ * @return  Connected file descriptor (-1 on failure).
+ **/
+int control_connect(const char *path) {
+    struct sockaddr_un addr;
+    if (!control_address(&addr, path)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,189 @@
+/* dag.c: PQSH Job Dependency Graph */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/dag.h"
+#include "../include/pqsh/intern.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Return bucket of job name (FNV-1a).
+ * @param   d           Pointer to Dag structure.
+ * @param   id          Job name.
+ **/
+static size_t dag_bucket(Dag *d, const char *id) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (; *id; id++) {
+        hash ^= (unsigned char)*id;
+        hash *= 1099511628211ULL;
+    }
+    return hash & (d->capacity - 1);
+}
+
+/**
+ * Double number of buckets once there are more named nodes than buckets.
+ * @param   d           Pointer to Dag structure.
+ * @return  Whether or not the table has room for another node.
+ **/
+static bool dag_grow(Dag *d) {
+    if (d->size < d->capacity) {
+        return true;
+    }
+
+    Dag grown = {
+        .capacity = d->capacity ? d->capacity * 2 : DAG_CAPACITY,
+    };
+    grown.buckets = calloc(grown.capacity, sizeof(DagNode *));
+    if (!grown.buckets) {
+        return false;
+    }
+
+    for (size_t i = 0; i < d->capacity; i++) {
+        for (DagNode *next, *n = d->buckets[i]; n; n = next) {
+            size_t bucket = dag_bucket(&grown, n->id);
+            next = n->next;
+            n->next = grown.buckets[bucket];
+            grown.buckets[bucket] = n;
+        }
+    }
+
+    free(d->buckets);
+    d->buckets  = grown.buckets;
+    d->capacity = grown.capacity;
+    return true;
+}
+
+/**
+ * Append node to array, doubling its allocation at powers of two.
+ * @return  Whether or not the node was appended.
+ **/
+static bool dag_append(DagNode ***array, size_t *size, DagNode *n) {
+    if ((*size & (*size - 1)) == 0) {
+        DagNode **grown = realloc(*array, (*size ? *size * 2 : 1) * sizeof(DagNode *));
+        if (!grown) {
+            return false;
+        }
+        *array = grown;
+    }
+    (*array)[(*size)++] = n;
+    return true;
+}
+
+/**
+ * Extend critical path of node's dependencies to include a longer path.
+ * @param   n           Pointer to DagNode whose rank increased.
+ **/
+static void dag_propagate(DagNode *n) {
+    for (size_t i = 0; i < n->nafter; i++) {
+        DagNode *a = n->after[i];
+        if (!a->finished && a->cost + n->rank > a->rank) {
+            a->rank = a->cost + n->rank;
+            dag_propagate(a);
+        }
+    }
+}
+
+/**
+ * Return named node.
+ * @param   d           Pointer to Dag structure.
+ * @param   id          Job name.
+ * @return  Pointer to DagNode (NULL if not found).
+ **/
+DagNode *dag_find(Dag *d, const char *id) {
+    if (!d->capacity) {
+        return NULL;
+    }
+
+    for (DagNode *n = d->buckets[dag_bucket(d, id)]; n; n = n->next) {
+        if (streq(n->id, id)) {
+            return n;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Add job to graph.
+ *
+ * Dependencies must already be in the graph, so the graph is acyclic by
+ * construction. The job's rank starts at its own cost, and every unfinished
+ * job it depends on (transitively) has its rank raised to cover the path
+ * through it.
+ *
+ * @param   d           Pointer to Dag structure.
+ * @param   p           Pointer to Process structure of job.
+ * @param   id          Job name (NULL == anonymous; must not already exist).
+ * @param   after       Jobs that must finish first.
+ * @param   nafter      Number of dependencies.
+ * @param   cost        Estimated run time of job (seconds).
+ * @return  Pointer to new DagNode (NULL on failure).
+ **/
+DagNode *dag_add(Dag *d, struct Process *p, const char *id, DagNode **after, size_t nafter, double cost) {
+    DagNode *n = calloc(1, sizeof(DagNode));
+    if (!n) {
+        return NULL;
+    }
+
+    n->process = p;
+    n->cost    = cost;
+    n->rank    = cost;
+    if (nafter) {
+        n->after = malloc(nafter * sizeof(DagNode *));
+        if (!n->after) {
+            free(n);
+            return NULL;
+        }
+        memcpy(n->after, after, nafter * sizeof(DagNode *));
+        n->nafter = nafter;
+    }
+
+    if (id) {
+        if (!dag_grow(d) || !(n->id = intern_acquire(id))) {
+            free(n->after);
+            free(n);
+            return NULL;
+        }
+        size_t bucket = dag_bucket(d, id);
+        n->next = d->buckets[bucket];
+        d->buckets[bucket] = n;
+        d->size++;
+    }
+    n->link  = d->nodes;
+    d->nodes = n;
+
+    for (size_t i = 0; i < nafter; i++) {
+        if (!dag_append(&after[i]->dependents, &after[i]->ndependents, n)) {
+            n->process = NULL;                                      // stays linked until released
+            return NULL;
+        }
+        n->pending += !after[i]->finished;
+        n->failed  |= after[i]->failed;
+    }
+    dag_propagate(n);
+    return n;
+}
+
+/**
+ * Release every node in graph.
+ * @param   d           Pointer to Dag structure.
+ **/
+void dag_release(Dag *d) {
+    while (d->nodes) {
+        DagNode *n = d->nodes;
+        d->nodes = n->link;
+        if (n->id) {
+            intern_release(n->id);
+        }
+        free(n->after);
+        free(n->dependents);
+        free(n);
+    }
+
+    free(d->buckets);
+    d->buckets  = NULL;
+    d->capacity = 0;
+    d->size     = 0;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,246 @@
+/* event.c: PQSH Event Loop */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/event.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+/* Constants */
+
+#define MAX_EVENTS  64
+
+/**
+ * Initialize event loop.
+ * @param   l           Pointer to EventLoop structure.
+ * @return  Whether or not the epoll instance was created successfully.
+ **/
+bool event_loop_init(EventLoop *l) {
+    l->fd       = epoll_create1(EPOLL_CLOEXEC);
+    l->running  = false;
+    l->watchers = NULL;
+    l->garbage  = NULL;
+    l->idle     = NULL;
+
+    if (l->fd < 0) {
+        error("Unable to epoll_create1: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Watch file descriptor for the specified events.
+ * @param   l           Pointer to EventLoop structure.
+ * @param   fd          File descriptor to watch.
+ * @param   events      Bitmask of epoll events (ie. EPOLLIN).
+ * @param   handler     Callback to invoke when fd is ready.
+ * @param   arg         Argument to pass to callback.
+ * @return  Whether or not the file descriptor was registered successfully.
+ **/
+bool event_loop_watch(EventLoop *l, int fd, uint32_t events, EventHandler handler, void *arg) {
+    EventWatcher *w = calloc(1, sizeof(EventWatcher));
+    if (!w) {
+        return false;
+    }
+
+    w->fd      = fd;
+    w->handler = handler;
+    w->arg     = arg;
+
+    struct epoll_event event = { .events = events, .data.ptr = w };
+    if (epoll_ctl(l->fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        error("Unable to epoll_ctl: %s", strerror(errno));
+        free(w);
+        return false;
+    }
+
+    w->next     = l->watchers;
+    l->watchers = w;
+    return true;
+}
+
+/**
+ * Change events watched for file descriptor.
+ * @param   l           Pointer to EventLoop structure.
+ * @param   fd          File descriptor being watched.
+ * @param   events      Bitmask of epoll events (ie. EPOLLIN | EPOLLOUT).
+ * @return  Whether or not the file descriptor was being watched.
+ **/
+bool event_loop_modify(EventLoop *l, int fd, uint32_t events) {
+    for (EventWatcher *w = l->watchers; w; w = w->next) {
+        if (w->fd == fd) {
+            struct epoll_event event = { .events = events, .data.ptr = w };
+            if (epoll_ctl(l->fd, EPOLL_CTL_MOD, fd, &event) < 0) {
+                error("Unable to epoll_ctl: %s", strerror(errno));
+                return false;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Stop watching file descriptor.
+ *
+ * The watcher is not released immediately since there may still be pending
+ * events for it in the current batch; it is released after dispatch.
+ *
+ * @param   l           Pointer to EventLoop structure.
+ * @param   fd          File descriptor to stop watching.
+ * @return  Whether or not the file descriptor was being watched.
+ **/
+bool event_loop_unwatch(EventLoop *l, int fd) {
+    for (EventWatcher **w = &l->watchers; *w; w = &(*w)->next) {
+        if ((*w)->fd == fd) {
+            EventWatcher *found = *w;
+            *w = found->next;
+
+            epoll_ctl(l->fd, EPOLL_CTL_DEL, fd, NULL);
+            found->handler = NULL;
+            found->next    = l->garbage;
+            l->garbage     = found;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Call handler (with fd -1) after each batch of events has been dispatched.
+ * @param   l           Pointer to EventLoop structure.
+ * @param   handler     Callback (NULL == none).
+ * @param   arg         Argument to pass to callback.
+ **/
+void event_loop_idle(EventLoop *l, EventHandler handler, void *arg) {
+    l->idle     = handler;
+    l->idle_arg = arg;
+}
+
+/**
+ * Dispatch events until event_loop_stop is called.
+ * @param   l           Pointer to EventLoop structure.
+ **/
+void event_loop_run(EventLoop *l) {
+    struct epoll_event events[MAX_EVENTS];
+
+    l->running = true;
+    while (l->running) {
+        int n = epoll_wait(l->fd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error("Unable to epoll_wait: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n && l->running; i++) {
+            EventWatcher *w = events[i].data.ptr;
+            if (w->handler) {
+                w->handler(l, w->fd, events[i].events, w->arg);
+            }
+        }
+
+        while (l->garbage) {
+            EventWatcher *w = l->garbage;
+            l->garbage = w->next;
+            free(w);
+        }
+
+        if (l->idle) {
+            l->idle(l, -1, 0, l->idle_arg);
+        }
+    }
+}
+
+/**
+ * Stop event loop after current handler returns.
+ * @param   l           Pointer to EventLoop structure.
+ **/
+void event_loop_stop(EventLoop *l) {
+    l->running = false;
+}
+
+/**
+ * Release event loop resources (does not close watched descriptors).
+ * @param   l           Pointer to EventLoop structure.
+ **/
+void event_loop_release(EventLoop *l) {
+    while (l->watchers) {
+        event_loop_unwatch(l, l->watchers->fd);
+    }
+
+    while (l->garbage) {
+        EventWatcher *w = l->garbage;
+        l->garbage = w->next;
+        free(w);
+    }
+
+    if (l->fd >= 0) {
+        close(l->fd);
+        l->fd = -1;
+    }
+}
+
+/**
+ * Create periodic timer file descriptor.
+ * @param   usec        Timer interval (microseconds).
+ * @return  Timer file descriptor (-1 on failure).
+ **/
+int event_timer_open(time_t usec) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        error("Unable to timerfd_create: %s", strerror(errno));
+        return -1;
+    }
+
+    if (!event_timer_set(fd, usec)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Set interval of periodic timer file descriptor.
+ * @param   fd          Timer file descriptor.
+ * @param   usec        Timer interval (microseconds).
+ * @return  Whether or not the timer was armed successfully.
+ **/
+bool event_timer_set(int fd, time_t usec) {
+    struct timespec interval = {
+        .tv_sec  = usec / 1000000,
+        .tv_nsec = (usec % 1000000) * 1000,
+    };
+    struct itimerspec spec = { .it_interval = interval, .it_value = interval };
+
+    if (timerfd_settime(fd, 0, &spec, NULL) < 0) {
+        error("Unable to timerfd_settime: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Return how long ago periodic timer file descriptor last expired.
+ * @param   fd          Timer file descriptor.
+ * @return  Time since last expiration (0 on failure).
+ **/
+Time event_timer_elapsed(int fd) {
+    struct itimerspec spec;
+
+    if (timerfd_gettime(fd, &spec) < 0) {
+        return 0;
+    }
+
+    Time interval  = spec.it_interval.tv_sec * NSEC_PER_SEC + spec.it_interval.tv_nsec;
+    Time remaining = spec.it_value.tv_sec * NSEC_PER_SEC + spec.it_value.tv_nsec;
+    return max(interval - remaining, (Time)0);
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
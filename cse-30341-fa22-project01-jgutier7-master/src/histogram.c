@@ -0,0 +1,112 @@
+/* histogram.c: PQSH Latency Histogram */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/histogram.h"
+
+/**
+ * Return bucket for value.
+ *
+ * Values below HISTOGRAM_SUB have exact buckets. Each power of two above
+ * that is split into HISTOGRAM_HALF linear sub-buckets, so the bucket width
+ * is always less than 1 / HISTOGRAM_HALF of the value.
+ *
+ * @param   value       Value in nanoseconds.
+ * @return  Bucket index.
+ **/
+static size_t histogram_index(uint64_t value) {
+    if (value < HISTOGRAM_SUB) {
+        return value;
+    }
+
+    value = min(value, (UINT64_C(1) << HISTOGRAM_MAX_BITS) - 1);
+    int msb   = 63 - __builtin_clzll(value);
+    int shift = msb - (HISTOGRAM_SUB_BITS - 1);
+    return HISTOGRAM_SUB + (shift - 1) * HISTOGRAM_HALF + ((value >> shift) - HISTOGRAM_HALF);
+}
+
+/**
+ * Return largest value that maps to bucket.
+ * @param   index       Bucket index.
+ * @return  Value in nanoseconds.
+ **/
+static uint64_t histogram_value(size_t index) {
+    if (index < HISTOGRAM_SUB) {
+        return index;
+    }
+
+    int      shift = (index - HISTOGRAM_SUB) / HISTOGRAM_HALF + 1;
+    uint64_t sub   = (index - HISTOGRAM_SUB) % HISTOGRAM_HALF + HISTOGRAM_HALF;
+    return ((sub + 1) << shift) - 1;
+}
+
+/**
+ * Record value.
+ * @param   h           Pointer to Histogram structure.
+ * @param   value       Value to record (negative values are recorded as 0).
+ **/
+void histogram_record(Histogram *h, Time value) {
+    value = max(value, (Time)0);
+    h->counts[histogram_index(value)]++;
+    h->count++;
+    h->sum += value;
+    h->max  = max(h->max, value);
+}
+
+/**
+ * Return value at or below which the given percentage of values fall.
+ * @param   h           Pointer to Histogram structure.
+ * @param   percentile  Percentage (0 - 100).
+ * @return  Value (never more than the recorded maximum).
+ **/
+Time histogram_percentile(const Histogram *h, double percentile) {
+    if (!h->count) {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t)(percentile / 100.0 * h->count + 0.5);
+    uint64_t seen   = 0;
+    target = max(target, (uint64_t)1);
+
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= target) {
+            if (i == HISTOGRAM_BUCKETS - 1) {
+                return h->max;                  // out of range values are clamped to the last bucket
+            }
+            return min((Time)histogram_value(i), h->max);
+        }
+    }
+    return h->max;
+}
+
+/**
+ * Return mean of recorded values.
+ * @param   h           Pointer to Histogram structure.
+ * @return  Mean (0 if empty).
+ **/
+Time histogram_mean(const Histogram *h) {
+    return h->count ? h->sum / (Time)h->count : 0;
+}
+
+/**
+ * Halve every count so recent values outweigh older ones.
+ * @param   h           Pointer to Histogram structure.
+ **/
+void histogram_decay(Histogram *h) {
+    uint64_t count = 0;
+    size_t   last  = 0;
+
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        h->counts[i] /= 2;
+        count += h->counts[i];
+        if (h->counts[i]) {
+            last = i;
+        }
+    }
+
+    h->sum   = h->count ? (Time)((double)h->sum * count / h->count) : 0;
+    h->count = count;
+    h->max   = count ? min(h->max, (Time)histogram_value(last)) : 0;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
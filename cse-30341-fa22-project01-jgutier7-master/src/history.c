@@ -0,0 +1,235 @@
+/* history.c: PQSH Runtime History */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/history.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Hash string using FNV-1a.
+ * @param   s           String to hash.
+ * @return  64-bit hash value.
+ **/
+static uint64_t history_hash(const char *s) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (; *s; s++) {
+        hash ^= (unsigned char)*s;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Find entry for command.
+ * @param   h           Pointer to History structure.
+ * @param   command     Command string.
+ * @return  Pointer to HistoryEntry (NULL if not found).
+ **/
+static HistoryEntry *history_find(History *h, const char *command) {
+    if (!h->capacity) {
+        return NULL;
+    }
+
+    HistoryEntry *e = h->buckets[history_hash(command) % h->capacity];
+    while (e && !streq(e->command, command)) {
+        e = e->next;
+    }
+    return e;
+}
+
+/**
+ * Double number of buckets once load factor exceeds one.
+ * @param   h           Pointer to History structure.
+ * @return  Whether or not the table has room for another entry.
+ **/
+static bool history_grow(History *h) {
+    if (h->size < h->capacity) {
+        return true;
+    }
+
+    size_t capacity = h->capacity ? h->capacity * 2 : HISTORY_BUCKETS;
+    HistoryEntry **buckets = calloc(capacity, sizeof(HistoryEntry *));
+    if (!buckets) {
+        return false;
+    }
+
+    for (size_t i = 0; i < h->capacity; i++) {
+        HistoryEntry *e = h->buckets[i];
+        while (e) {
+            HistoryEntry *next = e->next;
+            size_t bucket = history_hash(e->command) % capacity;
+            e->next = buckets[bucket];
+            buckets[bucket] = e;
+            e = next;
+        }
+    }
+
+    free(h->buckets);
+    h->buckets  = buckets;
+    h->capacity = capacity;
+    return true;
+}
+
+/**
+ * Insert new entry for command.
+ * @param   h           Pointer to History structure.
+ * @param   command     Command string.
+ * @param   estimate    Initial estimate (seconds).
+ * @param   count       Number of observations.
+ * @return  Pointer to new HistoryEntry (NULL on failure).
+ **/
+static HistoryEntry *history_insert(History *h, const char *command, double estimate, size_t count) {
+    if (!history_grow(h)) {
+        return NULL;
+    }
+
+    HistoryEntry *e = calloc(1, sizeof(HistoryEntry));
+    if (!e || !(e->command = strdup(command))) {
+        free(e);
+        return NULL;
+    }
+
+    size_t bucket = history_hash(command) % h->capacity;
+    e->estimate = estimate;
+    e->count    = count;
+    e->next     = h->buckets[bucket];
+    h->buckets[bucket] = e;
+    h->size++;
+    h->total += estimate;
+    return e;
+}
+
+/**
+ * Load history table from file.
+ *
+ * Each line has the form: ESTIMATE COUNT COMMAND
+ *
+ * @param   h           Pointer to History structure.
+ * @param   path        Path to history file.
+ * @return  Whether or not the file was loaded (a missing file is not an error).
+ **/
+bool history_load(History *h, const char *path) {
+    FILE *fs = fopen(path, "r");
+    if (!fs) {
+        return errno == ENOENT;
+    }
+
+    char   buffer[BUFSIZ];
+    double estimate;
+    size_t count;
+    int    offset;
+
+    while (fgets(buffer, BUFSIZ, fs)) {
+        chomp(buffer);
+        if (sscanf(buffer, "%lf %lu %n", &estimate, &count, &offset) != 2 || !buffer[offset]) {
+            continue;
+        }
+
+        HistoryEntry *e = history_find(h, buffer + offset);
+        if (e) {
+            h->total   += estimate - e->estimate;
+            e->estimate = estimate;
+            e->count    = count;
+        } else if (!history_insert(h, buffer + offset, estimate, count)) {
+            fclose(fs);
+            return false;
+        }
+    }
+
+    fclose(fs);
+    return true;
+}
+
+/**
+ * Save history table to file (atomically replacing the previous one).
+ * @param   h           Pointer to History structure.
+ * @param   path        Path to history file.
+ * @return  Whether or not the file was saved.
+ **/
+bool history_save(History *h, const char *path) {
+    char temporary[BUFSIZ];
+    snprintf(temporary, BUFSIZ, "%s.tmp", path);
+
+    FILE *fs = fopen(temporary, "w");
+    if (!fs) {
+        error("Unable to open %s: %s", temporary, strerror(errno));
+        return false;
+    }
+
+    for (size_t i = 0; i < h->capacity; i++) {
+        for (HistoryEntry *e = h->buckets[i]; e; e = e->next) {
+            fprintf(fs, "%.6lf %lu %s\n", e->estimate, e->count, e->command);
+        }
+    }
+
+    if (fclose(fs) != 0 || rename(temporary, path) < 0) {
+        error("Unable to save %s: %s", path, strerror(errno));
+        unlink(temporary);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Return predicted runtime of command.
+ * @param   h           Pointer to History structure.
+ * @param   command     Command string.
+ * @return  Learned estimate, or the mean of all estimates for unknown commands.
+ **/
+double history_estimate(History *h, const char *command) {
+    HistoryEntry *e = history_find(h, command);
+    if (e) {
+        return e->estimate;
+    }
+    return h->size ? h->total / h->size : 0.0;
+}
+
+/**
+ * Record observed runtime of command:
+ *
+ *  estimate = HISTORY_ALPHA * runtime + (1 - HISTORY_ALPHA) * estimate
+ *
+ * @param   h           Pointer to History structure.
+ * @param   command     Command string.
+ * @param   runtime     Observed runtime (seconds).
+ * @return  Whether or not the observation was recorded.
+ **/
+bool history_update(History *h, const char *command, double runtime) {
+    HistoryEntry *e = history_find(h, command);
+    if (!e) {
+        return history_insert(h, command, runtime, 1) != NULL;
+    }
+
+    double estimate = HISTORY_ALPHA * runtime + (1 - HISTORY_ALPHA) * e->estimate;
+    h->total   += estimate - e->estimate;
+    e->estimate = estimate;
+    e->count++;
+    return true;
+}
+
+/**
+ * Release history table.
+ * @param   h           Pointer to History structure.
+ **/
+void history_release(History *h) {
+    for (size_t i = 0; i < h->capacity; i++) {
+        HistoryEntry *e = h->buckets[i];
+        while (e) {
+            HistoryEntry *next = e->next;
+            free(e->command);
+            free(e);
+            e = next;
+        }
+    }
+
+    free(h->buckets);
+    h->buckets  = NULL;
+    h->capacity = 0;
+    h->size     = 0;
+    h->total    = 0;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
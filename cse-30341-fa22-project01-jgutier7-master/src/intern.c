@@ -0,0 +1,145 @@
+/* intern.c: PQSH Interned Strings */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/intern.h"
+
+/* Globals */
+
+static InternString   **Buckets  = NULL;    /* Hash buckets */
+static size_t           Capacity = 0;       /* Number of buckets */
+static size_t           Count    = 0;       /* Number of distinct strings */
+
+/**
+ * Hash string using FNV-1a.
+ * @param   s           String to hash.
+ * @return  64-bit hash value.
+ **/
+static uint64_t intern_hash(const char *s) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (; *s; s++) {
+        hash ^= (unsigned char)*s;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Double number of buckets once load factor exceeds one.
+ * @return  Whether or not the table has room for another entry.
+ **/
+static bool intern_grow(void) {
+    if (Count < Capacity) {
+        return true;
+    }
+
+    size_t capacity = Capacity ? Capacity * 2 : INTERN_BUCKETS;
+    InternString **buckets = calloc(capacity, sizeof(InternString *));
+    if (!buckets) {
+        return false;
+    }
+
+    for (size_t i = 0; i < Capacity; i++) {
+        InternString *e = Buckets[i];
+        while (e) {
+            InternString *next = e->next;
+            e->next = buckets[e->hash % capacity];
+            buckets[e->hash % capacity] = e;
+            e = next;
+        }
+    }
+
+    free(Buckets);
+    Buckets  = buckets;
+    Capacity = capacity;
+    return true;
+}
+
+/**
+ * Return shared copy of string, incrementing its reference count.
+ *
+ * Identical strings map to the same storage, so callers may compare interned
+ * strings by pointer.
+ *
+ * @param   s           String to intern.
+ * @return  Pointer to interned string (NULL on failure).
+ **/
+const char *intern_acquire(const char *s) {
+    uint64_t hash = intern_hash(s);
+
+    if (Capacity) {
+        for (InternString *e = Buckets[hash % Capacity]; e; e = e->next) {
+            if (e->hash == hash && streq(e->string, s)) {
+                e->refs++;
+                return e->string;
+            }
+        }
+    }
+
+    if (!intern_grow()) {
+        return NULL;
+    }
+
+    size_t length = strlen(s);
+    InternString *e = malloc(sizeof(InternString) + length + 1);
+    if (!e) {
+        return NULL;
+    }
+
+    memcpy(e->string, s, length + 1);
+    e->hash = hash;
+    e->refs = 1;
+    e->argv = NULL;
+    e->next = Buckets[hash % Capacity];
+    Buckets[hash % Capacity] = e;
+    Count++;
+    return e->string;
+}
+
+/**
+ * Drop reference to interned string, freeing it (and its cached argument
+ * vector) once the last reference is gone.
+ * @param   s           Pointer returned by intern_acquire.
+ **/
+void intern_release(const char *s) {
+    if (!s) {
+        return;
+    }
+
+    InternString *entry = intern_entry(s);
+    if (--entry->refs) {
+        return;
+    }
+
+    InternString **link = &Buckets[entry->hash % Capacity];
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+
+    free(entry->argv);
+    free(entry);
+
+    if (--Count == 0) {
+        free(Buckets);
+        Buckets  = NULL;
+        Capacity = 0;
+    }
+}
+
+/**
+ * Return entry that owns interned string.
+ * @param   s           Pointer returned by intern_acquire.
+ * @return  Pointer to InternString structure.
+ **/
+InternString *intern_entry(const char *s) {
+    return container_of(s, InternString, string);
+}
+
+/**
+ * Return number of distinct interned strings.
+ **/
+size_t intern_count(void) {
+    return Count;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
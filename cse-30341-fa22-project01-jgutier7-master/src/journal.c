@@ -0,0 +1,147 @@
+/* journal.c: PQSH Write-Ahead Journal */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/journal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Write buffered records to the file (without syncing).
+ * @param   j           Pointer to Journal structure.
+ * @return  Whether or not every record was written.
+ **/
+static bool journal_write(Journal *j) {
+    size_t written = 0;
+
+    while (written < j->size) {
+        ssize_t nwritten = write(j->fd, j->buffer + written, j->size - written);
+        if (nwritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nwritten <= 0) {
+            error("Unable to write journal %s: %s", j->path, strerror(errno));
+            memmove(j->buffer, j->buffer + written, j->size - written);
+            j->size -= written;
+            return false;
+        }
+        written += nwritten;
+    }
+
+    j->size  = 0;
+    j->dirty = j->dirty || written;
+    return true;
+}
+
+/**
+ * Open journal for appending.
+ * @param   j           Pointer to Journal structure.
+ * @param   path        Path of journal.
+ * @param   truncate    Whether or not to discard existing records.
+ * @return  Whether or not the journal was opened.
+ **/
+bool journal_open(Journal *j, const char *path, bool truncate) {
+    j->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+    if (j->fd < 0) {
+        error("Unable to open journal %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    j->buffer = malloc(JOURNAL_BUFFER);
+    if (!j->buffer) {
+        close(j->fd);
+        return false;
+    }
+
+    j->path  = path;
+    j->size  = 0;
+    j->dirty = false;
+    return true;
+}
+
+/**
+ * Append record to journal buffer.
+ *
+ * Records are only written once the buffer fills or the journal is
+ * committed, so appending costs one formatted copy.
+ *
+ * @param   j           Pointer to Journal structure.
+ * @param   format      printf format of record (including trailing newline).
+ * @return  Whether or not the record was buffered.
+ **/
+bool journal_append(Journal *j, const char *format, ...) {
+    if (!j->path || j->replaying) {
+        return true;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(j->buffer + j->size, JOURNAL_BUFFER - j->size, format, args);
+        va_end(args);
+
+        if (length < 0 || length >= JOURNAL_BUFFER) {
+            error("Journal record too long");
+            return false;
+        }
+        if ((size_t)length < JOURNAL_BUFFER - j->size) {
+            j->size += length;
+            return true;
+        }
+        if (!journal_write(j)) {                                    // full: make room and format again
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * Write and sync every record appended so far (group commit).
+ *
+ * Everything appended since the last commit shares one fdatasync, so
+ * callers should commit once per batch of work before acknowledging it.
+ *
+ * @param   j           Pointer to Journal structure.
+ * @return  Whether or not every record is durable.
+ **/
+bool journal_commit(Journal *j) {
+    if (!j->path) {
+        return true;
+    }
+    if (!journal_write(j)) {
+        return false;
+    }
+    if (!j->dirty) {
+        return true;
+    }
+
+    if (fdatasync(j->fd) < 0) {
+        error("Unable to sync journal %s: %s", j->path, strerror(errno));
+        return false;
+    }
+    j->dirty = false;
+    j->commits++;
+    return true;
+}
+
+/**
+ * Commit outstanding records and close journal.
+ * @param   j           Pointer to Journal structure.
+ **/
+void journal_close(Journal *j) {
+    if (!j->path) {
+        return;
+    }
+
+    journal_commit(j);
+    close(j->fd);
+    free(j->buffer);
+    j->path   = NULL;
+    j->buffer = NULL;
+    j->fd     = -1;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,145 @@
+/* lottery.c: PQSH Lottery */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/lottery.h"
+#include "../include/pqsh/process.h"
+
+/**
+ * Add delta tickets to entry in Fenwick tree (delta may wrap around to
+ * subtract).
+ * @param   l           Pointer to Lottery structure.
+ * @param   i           Index of entry.
+ * @param   delta       Number of tickets to add.
+ **/
+static void lottery_update(Lottery *l, size_t i, size_t delta) {
+    for (size_t j = i + 1; j <= l->capacity; j += j & -j) {
+        l->sums[j] += delta;
+    }
+}
+
+/**
+ * Double number of entries and rebuild Fenwick tree in linear time.
+ * @param   l           Pointer to Lottery structure.
+ * @return  Whether or not the lottery has room for another entry.
+ **/
+static bool lottery_grow(Lottery *l) {
+    if (l->size < l->capacity) {
+        return true;
+    }
+
+    size_t    capacity = l->capacity ? l->capacity * 2 : LOTTERY_CAPACITY;
+    Process **entries  = realloc(l->entries, capacity * sizeof(Process *));
+    if (!entries) {
+        return false;
+    }
+    l->entries = entries;
+
+    size_t *sums = calloc(capacity + 1, sizeof(size_t));
+    if (!sums) {
+        return false;
+    }
+    for (size_t j = 1; j <= capacity; j++) {
+        if (j <= l->size) {
+            sums[j] += l->entries[j - 1]->tickets;
+        }
+        size_t parent = j + (j & -j);
+        if (parent <= capacity) {
+            sums[parent] += sums[j];
+        }
+    }
+
+    free(l->sums);
+    l->sums     = sums;
+    l->capacity = capacity;
+    return true;
+}
+
+/**
+ * Give process its tickets in the lottery.
+ * @param   l           Pointer to Lottery structure.
+ * @param   p           Pointer to Process structure (not in lottery).
+ * @return  Whether or not the process was added.
+ **/
+bool lottery_insert(Lottery *l, Process *p) {
+    if (!lottery_grow(l)) {
+        return false;
+    }
+
+    p->entry = l->size++;
+    l->entries[p->entry] = p;
+    lottery_update(l, p->entry, p->tickets);
+    l->total += p->tickets;
+    return true;
+}
+
+/**
+ * Take tickets of process out of the lottery (the last entry moves into its
+ * place).
+ * @param   l           Pointer to Lottery structure.
+ * @param   p           Pointer to Process structure in lottery.
+ **/
+void lottery_remove(Lottery *l, Process *p) {
+    size_t   last  = --l->size;
+    Process *moved = l->entries[last];
+
+    lottery_update(l, p->entry, -p->tickets);
+    l->total -= p->tickets;
+    if (moved != p) {
+        lottery_update(l, last, -moved->tickets);
+        lottery_update(l, p->entry, moved->tickets);
+        moved->entry = p->entry;
+        l->entries[moved->entry] = moved;
+    }
+    l->entries[last] = NULL;
+}
+
+/**
+ * Return whether process holds tickets in the lottery.
+ * @param   l           Pointer to Lottery structure.
+ * @param   p           Pointer to Process structure.
+ **/
+bool lottery_contains(const Lottery *l, const Process *p) {
+    return p->entry < l->size && l->entries[p->entry] == p;
+}
+
+/**
+ * Return process holding ticket by descending the Fenwick tree.
+ * @param   l           Pointer to Lottery structure.
+ * @param   ticket      Winning ticket (less than total).
+ * @return  Pointer to Process structure (NULL if no process holds ticket).
+ **/
+Process *lottery_draw(const Lottery *l, size_t ticket) {
+    if (ticket >= l->total) {
+        return NULL;
+    }
+
+    size_t step = 1;
+    while (step * 2 <= l->capacity) {
+        step *= 2;
+    }
+
+    size_t i = 0;
+    for (; step; step /= 2) {
+        if (i + step <= l->capacity && l->sums[i + step] <= ticket) {
+            i      += step;
+            ticket -= l->sums[i];
+        }
+    }
+    return l->entries[i];
+}
+
+/**
+ * Release lottery (processes are not deleted).
+ * @param   l           Pointer to Lottery structure.
+ **/
+void lottery_release(Lottery *l) {
+    free(l->entries);
+    free(l->sums);
+    l->entries  = NULL;
+    l->sums     = NULL;
+    l->capacity = 0;
+    l->size     = 0;
+    l->total    = 0;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
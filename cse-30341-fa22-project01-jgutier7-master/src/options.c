@@ -3,6 +3,12 @@
 #include "../include/pqsh/macros.h"
 #include "../include/pqsh/scheduler.h"
 
+#include <string.h>
+
+/* Constants */
+
+#define OPTIONS_WITH_VALUES "nptAgMlbLfJSORoTH"     /* Options followed by a value */
+
 /**
  * Display usage message.
  * @param       program     String containing name of program.
@@ -11,8 +17,26 @@ void usage(const char *program) {
     fprintf(stderr, "Usage: %s [options]\n\n", program);
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "    -n CORES           Number of CPU cores to utilize\n");
-    fprintf(stderr, "    -p POLICY          Scheduling policy (fifo, rdrn)\n");
+    fprintf(stderr, "    -a                 Pin cores to CPUs and use per-core run queues\n");
+    fprintf(stderr, "    -p POLICY          Scheduling policy (fifo, rdrn, mlfq, cfs, srtf, lottery, stride, edf, fair)\n");
     fprintf(stderr, "    -t MICROSECONDS    Timer interrupt interval\n");
+    fprintf(stderr, "    -A PERCENT         Adapt rdrn time slice (at most -t) to keep preemption overhead below PERCENT\n");
+    fprintf(stderr, "    -g NAME:WEIGHT[:POLICY] Share cores with fair tenant NAME by WEIGHT, running its jobs by POLICY (fifo, rdrn)\n");
+    fprintf(stderr, "    -s                 Swap sleeping rdrn processes out of their cores for waiting ones\n");
+    fprintf(stderr, "    -M PERCENT         Hold fifo jobs while memory pressure exceeds PERCENT and run more while they wait on I/O\n");
+    fprintf(stderr, "    -I                 Measure preemption stop latency, resume cost, and context switches\n");
+    fprintf(stderr, "    -c                 Timestamp with the TSC calibrated against the monotonic clock (invariant TSC only)\n");
+    fprintf(stderr, "    -L LAUNCH          Process launch mechanism (fork, vfork, spawn)\n");
+    fprintf(stderr, "    -l LEVELS          Number of MLFQ priority levels (1-%d)\n", MLFQ_MAX_LEVELS);
+    fprintf(stderr, "    -b MICROSECONDS    MLFQ priority boost period (0 disables)\n");
+    fprintf(stderr, "    -f FILE            Run jobs in FILE (- for stdin) to completion and exit\n");
+    fprintf(stderr, "    -J PATH            Journal jobs to PATH and recover unfinished ones from it at startup\n");
+    fprintf(stderr, "    -S PATH            Accept commands from local clients on UNIX socket PATH\n");
+    fprintf(stderr, "    -O DIRECTORY       Capture each job's stdout and stderr in DIRECTORY/PID-START.log\n");
+    fprintf(stderr, "    -R BYTES           Capture each job's stdout and stderr in a ring buffer of BYTES (default %d)\n", CAPTURE_RING);
+    fprintf(stderr, "    -o PATH            Write per-job metrics at exit (JSON if PATH ends in .json, else CSV)\n");
+    fprintf(stderr, "    -T PATH            Write scheduling timeline at exit (Chrome trace JSON)\n");
+    fprintf(stderr, "    -H PATH            Run time history file (default ~/%s with srtf)\n", HISTORY_FILE);
     fprintf(stderr, "    -h                 Print this help message\n");
 }
 
@@ -30,16 +54,39 @@ bool parse_command_line_options(int argc, char *argv[], Scheduler *s) {
 	char *arg = argv[argind++];
 	char *opt = NULL;
 
+	if (strchr(OPTIONS_WITH_VALUES, arg[1]) && argind >= argc) {
+	    fprintf(stderr, "Missing value for option: %s\n", arg);
+	    usage(argv[0]);
+	    return false;
+	}
+
 		switch (arg[1]) {
 			case 'n':
 				s->cores = atoi(argv[argind++]);
 				break;
+			case 'a':
+				s->affinity = true;
+				break;
 			case 'p':
 				opt = argv[argind++];
 				if (streq(opt, "fifo")) {
 					s->policy = FIFO_POLICY;
 					} else if (streq(opt, "rdrn")) {
 					s->policy = RDRN_POLICY;
+					} else if (streq(opt, "mlfq")) {
+					s->policy = MLFQ_POLICY;
+					} else if (streq(opt, "cfs")) {
+					s->policy = CFS_POLICY;
+					} else if (streq(opt, "srtf")) {
+					s->policy = SRTF_POLICY;
+					} else if (streq(opt, "lottery")) {
+					s->policy = LOTTERY_POLICY;
+					} else if (streq(opt, "stride")) {
+					s->policy = STRIDE_POLICY;
+					} else if (streq(opt, "edf")) {
+					s->policy = EDF_POLICY;
+					} else if (streq(opt, "fair")) {
+					s->policy = FAIR_POLICY;
 					} else {
 						fprintf(stderr, "Unknown policy: %s\n", opt);
 						return false;
@@ -48,6 +95,82 @@ bool parse_command_line_options(int argc, char *argv[], Scheduler *s) {
 			case 't':
 				s->timeout = atoi(argv[argind++]);
 				break;
+			case 'A':
+				s->overhead = atof(argv[argind++]) / 100.0;
+				if (s->overhead <= 0 || s->overhead >= 1) {
+					fprintf(stderr, "Invalid overhead percentage: %s\n", argv[argind - 1]);
+					return false;
+				}
+				break;
+			case 'g':
+				if (!scheduler_tenant_config(s, argv[argind++])) {
+					fprintf(stderr, "Invalid tenant: %s\n", argv[argind - 1]);
+					return false;
+				}
+				break;
+			case 's':
+				s->swap_sleeping = true;
+				break;
+			case 'M':
+				s->memory_limit = atof(argv[argind++]) / 100.0;
+				if (s->memory_limit <= 0 || s->memory_limit >= 1) {
+					fprintf(stderr, "Invalid memory pressure percentage: %s\n", argv[argind - 1]);
+					return false;
+				}
+				break;
+			case 'I':
+				s->instrument = true;
+				break;
+			case 'c':
+				if (!timestamp_tsc()) {
+					fprintf(stderr, "No invariant TSC, using monotonic clock\n");
+				}
+				break;
+			case 'l':
+				s->levels = atoi(argv[argind++]);
+				if (s->levels < 1 || s->levels > MLFQ_MAX_LEVELS) {
+					fprintf(stderr, "Invalid number of levels: %lu\n", s->levels);
+					return false;
+				}
+				break;
+			case 'b':
+				s->boost = atoi(argv[argind++]);
+				break;
+			case 'L':
+				opt = argv[argind++];
+				if (!process_launch_mode(opt, &s->launch)) {
+					fprintf(stderr, "Unknown launch mechanism: %s\n", opt);
+					return false;
+				}
+				break;
+			case 'f':
+				s->batch_path = argv[argind++];
+				break;
+			case 'J':
+				s->journal_path = argv[argind++];
+				break;
+			case 'S':
+				s->socket_path = argv[argind++];
+				break;
+			case 'O':
+				s->capture.directory = argv[argind++];
+				break;
+			case 'R':
+				s->capture.size = strtoul(argv[argind++], NULL, 10);
+				if (!s->capture.size) {
+					fprintf(stderr, "Invalid ring buffer size\n");
+					return false;
+				}
+				break;
+			case 'o':
+				s->metrics_path = argv[argind++];
+				break;
+			case 'T':
+				s->trace_path = argv[argind++];
+				break;
+			case 'H':
+				s->history_path = argv[argind++];
+				break;
 			case 'h':
 				usage(argv[0]);
 				return false;
@@ -57,6 +180,22 @@ bool parse_command_line_options(int argc, char *argv[], Scheduler *s) {
 		}
     }
 
+    if (s->overhead > 0 && s->policy != RDRN_POLICY) {
+        fprintf(stderr, "Adaptive time slice requires rdrn policy\n");
+        return false;
+    }
+    if (s->swap_sleeping && s->policy != RDRN_POLICY) {
+        fprintf(stderr, "Swapping sleeping processes requires rdrn policy\n");
+        return false;
+    }
+    if (s->ntenants && s->policy != FAIR_POLICY) {
+        fprintf(stderr, "Tenant weights require fair policy\n");
+        return false;
+    }
+    if (s->memory_limit > 0 && s->policy != FIFO_POLICY) {
+        fprintf(stderr, "Admission control requires fifo policy\n");
+        return false;
+    }
     return true;
 }
 
@@ -0,0 +1,142 @@
+/* pidmap.c: PQSH Process Identifier Index */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/pidmap.h"
+#include "../include/pqsh/process.h"
+
+#include <stdint.h>
+
+/**
+ * Return home slot of pid (Fibonacci hashing: the top log2(capacity) bits of
+ * pid * 2^32 / phi, which spread sequential pids across the whole table).
+ * @param   m           Pointer to PidMap structure.
+ * @param   pid         Process identifier.
+ **/
+static size_t pidmap_slot(PidMap *m, pid_t pid) {
+    return (size_t)(((uint32_t)pid * 2654435769U) >> (32 - __builtin_ctzl(m->capacity)));
+}
+
+/**
+ * Double number of slots once the table is three quarters full.
+ * @param   m           Pointer to PidMap structure.
+ * @return  Whether or not the table has room for another entry.
+ **/
+static bool pidmap_grow(PidMap *m) {
+    if (4 * (m->size + 1) <= 3 * m->capacity) {
+        return true;
+    }
+
+    PidMap grown = {
+        .entries  = calloc(m->capacity ? m->capacity * 2 : PIDMAP_CAPACITY, sizeof(PidEntry)),
+        .capacity = m->capacity ? m->capacity * 2 : PIDMAP_CAPACITY,
+    };
+    if (!grown.entries) {
+        return false;
+    }
+
+    for (size_t i = 0; i < m->capacity; i++) {
+        if (m->entries[i].pid) {
+            pidmap_insert(&grown, m->entries[i].pid, m->entries[i].process);
+        }
+    }
+
+    free(m->entries);
+    *m = grown;
+    return true;
+}
+
+/**
+ * Index process by pid (replacing any previous entry for the pid).
+ * @param   m           Pointer to PidMap structure.
+ * @param   pid         Process identifier (must be non-zero).
+ * @param   p           Pointer to Process structure.
+ * @return  Whether or not the process was indexed.
+ **/
+bool pidmap_insert(PidMap *m, pid_t pid, Process *p) {
+    if (!pid || !pidmap_grow(m)) {
+        return false;
+    }
+
+    size_t i = pidmap_slot(m, pid);
+    while (m->entries[i].pid && m->entries[i].pid != pid) {
+        i = (i + 1) & (m->capacity - 1);
+    }
+
+    if (!m->entries[i].pid) {
+        m->size++;
+    }
+    m->entries[i].pid     = pid;
+    m->entries[i].process = p;
+    return true;
+}
+
+/**
+ * Return process with pid.
+ * @param   m           Pointer to PidMap structure.
+ * @param   pid         Process identifier.
+ * @return  Pointer to Process structure (NULL if not found).
+ **/
+Process *pidmap_find(PidMap *m, pid_t pid) {
+    if (!pid || !m->capacity) {
+        return NULL;
+    }
+
+    for (size_t i = pidmap_slot(m, pid); m->entries[i].pid; i = (i + 1) & (m->capacity - 1)) {
+        if (m->entries[i].pid == pid) {
+            return m->entries[i].process;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Remove and return process with pid.
+ *
+ * Later entries in the probe sequence are shifted back into the hole, so no
+ * tombstones are needed and lookups stay short.
+ *
+ * @param   m           Pointer to PidMap structure.
+ * @param   pid         Process identifier.
+ * @return  Pointer to removed Process structure (NULL if not found).
+ **/
+Process *pidmap_remove(PidMap *m, pid_t pid) {
+    if (!pid || !m->capacity) {
+        return NULL;
+    }
+
+    size_t mask = m->capacity - 1;
+    size_t hole = pidmap_slot(m, pid);
+    while (m->entries[hole].pid != pid) {
+        if (!m->entries[hole].pid) {
+            return NULL;
+        }
+        hole = (hole + 1) & mask;
+    }
+
+    Process *p = m->entries[hole].process;
+    for (size_t i = (hole + 1) & mask; m->entries[i].pid; i = (i + 1) & mask) {
+        size_t home = pidmap_slot(m, m->entries[i].pid);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            m->entries[hole] = m->entries[i];
+            hole = i;
+        }
+    }
+
+    m->entries[hole].pid     = 0;
+    m->entries[hole].process = NULL;
+    m->size--;
+    return p;
+}
+
+/**
+ * Release pid index (the indexed processes are not freed).
+ * @param   m           Pointer to PidMap structure.
+ **/
+void pidmap_release(PidMap *m) {
+    free(m->entries);
+    m->entries  = NULL;
+    m->capacity = 0;
+    m->size     = 0;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -1,95 +1,637 @@
 /* pqsh.c: Process Queue Shell */
 
+#define _GNU_SOURCE
+
 #include "../include/pqsh/macros.h"
+#include "../include/pqsh/control.h"
+#include "../include/pqsh/event.h"
 #include "../include/pqsh/options.h"
 #include "../include/pqsh/scheduler.h"
 #include "../include/pqsh/signal.h"
+#include "../include/pqsh/timestamp.h"
 
 #include <errno.h>
 #include <string.h>
-#include <sys/time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 
 /* Global Variables */
 
-Scheduler PQShellScheduler = {                                                  // default scheduling FIFO 
+Scheduler PQShellScheduler = {                                                  // default scheduling FIFO
     .policy    = FIFO_POLICY,
     .cores     = 1,
     .timeout   = 250000,
+    .launch    = LAUNCH_SPAWN,
+    .levels    = 3,
+    .boost     = 1000000,
+};
+
+EventLoop PQShellLoop;
+
+typedef bool (*Executor)(Scheduler *s, FILE *fs, char *line);
+
+Executor  PQShellExecute;                                                       // handles each line of input
+bool      PQShellInputDone = false;                                             // batch input has been fully read
+
+/* Control socket clients */
+
+typedef struct Client Client;
+
+struct Client {
+    int     fd;                 /* Connected socket */
+    char    input[BUFSIZ];      /* Partial command line */
+    size_t  length;             /* Bytes in input */
+    char   *output;             /* Replies not yet written */
+    size_t  pending;            /* Bytes in output */
+    size_t  capacity;           /* Allocated bytes of output */
+    bool    closing;            /* Client is done sending (close once replies are written) */
+    Client *next;               /* Next connected client */
 };
 
+Client   *PQShellClients = NULL;                                                // connected control socket clients
+
 /* Help Message */
 
-void help() {
-    printf("Commands:\n");
-    printf("  add    command    Add command to waiting queue.\n");
-    printf("  status [queue]    Display status of specified queue (default is all).\n");
-    printf("  help              Display help message.\n");
-    printf("  exit|quit         Exit shell.\n");
+void help(FILE *fs) {
+    fprintf(fs, "Commands:\n");
+    fprintf(fs, "  add    [-w WEIGHT] [-t TICKETS] [--deadline SECONDS] [--tenant NAME] [--id NAME] [--after NAME,...] command\n");
+    fprintf(fs, "                    Add command to waiting queue (blocked until NAMEs finish).\n");
+    fprintf(fs, "  status [queue]    Display status of specified queue (default is all).\n");
+    fprintf(fs, "  status stats      Display latency percentiles, resource usage, and preemption cost (-I).\n");
+    fprintf(fs, "  status PID        Display job and its captured output.\n");
+    fprintf(fs, "  help              Display help message.\n");
+    fprintf(fs, "  exit|quit         Exit shell (or disconnect socket client).\n");
+}
+
+/* Shell */
+
+void prompt() {
+    printf("\nPQSH> ");
+    fflush(stdout);
+}
+
+/**
+ * Execute shell command.
+ * @param   s           Pointer to Scheduler structure.
+ * @param   fs          Output file stream for replies.
+ * @param   command     Command line (without trailing newline).
+ * @return  Whether or not the shell should continue running.
+ **/
+bool execute(Scheduler *s, FILE *fs, char *command) {
+    if (streq(command, "help")) {
+        help(fs);
+    } else if (strncmp(command, "add", 3) == 0 && (command[3] == ' ' || !command[3])) {
+        char *argument = command + 3;
+        while (*argument == ' ') argument++;
+
+        if (!*argument) {                                                       // tried to add nothing
+            help(fs);
+            return true;
+        }
+        scheduler_add(s, fs, argument);
+        if (s->running.size < s->limit || s->policy == EDF_POLICY || s->policy == SRTF_POLICY) {  // arrival only dispatches onto idle cores (edf, srtf: or preempts)
+            scheduler_next(s);
+        }
+    } else if (strncmp(command, "status", 6) == 0) {
+        char *argument = command + 6;
+        while (*argument == ' ') argument++;
+        if (*argument >= '0' && *argument <= '9') {
+            scheduler_output(s, fs, atoi(argument));
+            return true;
+        }
+
+        int queue = 0;
+        if (strstr(command, "running") != NULL) queue = RUNNING;
+        else if (strstr(command, "waiting") != NULL) queue = WAITING;
+        else if (strstr(command, "finished") != NULL) queue = FINISHED;
+        else if (strstr(command, "stats") != NULL) queue = STATS;
+        scheduler_status(s, fs, queue);
+    } else if (streq(command, "exit") || streq(command, "quit")) {
+        return false;
+    } else if (strlen(command)) {
+        fprintf(fs, "Unknown command: %s\n", command);
+    }
+    return true;
+}
+
+/* Batch */
+
+/**
+ * Add batch job line (blank lines and # comments are ignored).
+ * @param   s           Pointer to Scheduler structure.
+ * @param   fs          Output file stream (unused: only errors are reported, to stderr).
+ * @param   line        Job line (without trailing newline).
+ * @return  Always true (bad jobs are reported and skipped).
+ **/
+bool batch_execute(Scheduler *s, FILE *fs, char *line) {
+    while (*line == ' ' || *line == '\t') line++;
+    if (*line && *line != '#') {
+        scheduler_add(s, NULL, line);
+    }
+    return true;
+}
+
+/**
+ * Add every job in stream before scheduling any of them.
+ * @param   s           Pointer to Scheduler structure.
+ * @param   fs          Input file stream.
+ **/
+void batch_load(Scheduler *s, FILE *fs) {
+    char buffer[BUFSIZ];
+
+    while (fgets(buffer, BUFSIZ, fs)) {
+        chomp(buffer);
+        batch_execute(s, NULL, buffer);
+    }
+    PQShellInputDone = true;
+}
+
+/**
+ * Stop event loop once all batch input has been read and every job finished.
+ **/
+void batch_check(EventLoop *l, Scheduler *s) {
+    if (s->batch_path && PQShellInputDone && !s->running.size && !scheduler_waiting(s)) {
+        event_loop_stop(l);
+    }
+}
+
+/**
+ * Write batch summary to stream.
+ * @param   s           Pointer to Scheduler structure.
+ * @param   fs          Output file stream.
+ * @param   elapsed     Time batch took.
+ * @return  Number of jobs that failed.
+ **/
+size_t batch_summary(Scheduler *s, FILE *fs, Time elapsed) {
+    size_t failed     = 0;
+    Time   turnaround = 0;
+
+    for (Process *p = s->finished.head; p; p = p->next) {
+        if (!WIFEXITED(p->status) || WEXITSTATUS(p->status)) {
+            failed++;
+        }
+        turnaround += p->end_time - p->arrival_time;
+    }
+
+    size_t jobs    = s->finished.size;
+    double seconds = time_to_seconds(elapsed);
+    fprintf(fs, "Jobs = %lu, Failed = %lu, Elapsed = %.2lf, Throughput = %.2lf jobs/s, Turnaround = %.2lf\n",
+        jobs, failed, seconds, seconds > 0 ? jobs / seconds : 0.0, jobs ? time_to_seconds(turnaround) / jobs : 0.0);
+    return failed;
+}
+
+/* Event Handlers */
+
+/**
+ * Reap exited children and hand their cores to waiting processes.
+ *
+ * Children stopped by preemption also raise SIGCHLD; those must not trigger
+ * another scheduling decision before the time slice expires.
+ **/
+void child_handler(EventLoop *l, int fd, uint32_t events, void *arg) {
+    Scheduler *s = arg;
+    signal_drain(fd);
+    if (scheduler_wait(s)) {
+        scheduler_next(s);
+        batch_check(l, s);
+    }
+}
+
+/**
+ * Timer interrupt: the current time slice has expired.
+ *
+ * With an adaptive slice, interrupts that preempted something are timed from
+ * expiration to the end of rescheduling, and the timer is re-armed whenever
+ * the slice changes.
+ **/
+void timer_handler(EventLoop *l, int fd, uint32_t events, void *arg) {
+    Scheduler *s      = arg;
+    Time      late    = event_timer_elapsed(fd);
+    Time      begin   = timestamp();
+    size_t    paused  = s->preemptions;
+    time_t    slice   = s->slice;
+    uint64_t  expirations;
+
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return;
+    }
+    scheduler_wait(s);
+    scheduler_next(s);
+
+    if (s->overhead > 0) {
+        if (s->preemptions != paused) {
+            scheduler_slice_cost(s, late + timestamp() - begin);
+        }
+        if (scheduler_slice(s) != slice) {
+            event_timer_set(fd, s->slice);
+        }
+    }
+    batch_check(l, s);
+}
+
+/**
+ * Read shell input and execute each complete line.
+ *
+ * In batch mode every line is a job, and each chunk of jobs read is scheduled
+ * at once rather than line by line.
+ **/
+void input_handler(EventLoop *l, int fd, uint32_t events, void *arg) {
+    static char   buffer[BUFSIZ];
+    static size_t length = 0;
+    Scheduler *s = arg;
+
+    ssize_t nread = read(fd, buffer + length, sizeof(buffer) - length - 1);
+    if (nread < 0 && (errno == EINTR || errno == EAGAIN)) {
+        return;
+    }
+
+    if (nread <= 0) {                                                           // EOF: flush partial line and exit
+        buffer[length] = 0;
+        if (length) {
+            PQShellExecute(s, stdout, buffer);
+        }
+        if (s->batch_path) {                                                    // batch: exit once jobs finish
+            PQShellInputDone = true;
+            event_loop_unwatch(l, fd);
+            scheduler_next(s);
+            batch_check(l, s);
+        } else if (s->socket_path) {                                            // keep serving socket clients
+            event_loop_unwatch(l, fd);
+        } else {
+            event_loop_stop(l);
+        }
+        return;
+    }
+
+    length += nread;
+    buffer[length] = 0;
+
+    char *line = buffer;
+    char *newline;
+    while ((newline = memchr(line, '\n', length - (line - buffer)))) {
+        *newline = 0;
+        if (!PQShellExecute(s, stdout, line)) {
+            event_loop_stop(l);
+            return;
+        }
+        if (!s->batch_path) prompt();
+        line = newline + 1;
+    }
+
+    length -= line - buffer;
+    memmove(buffer, line, length);
+
+    if (length == sizeof(buffer) - 1) {                                         // line too long: execute what we have
+        buffer[length] = 0;
+        length = 0;
+        if (!PQShellExecute(s, stdout, buffer)) {
+            event_loop_stop(l);
+            return;
+        }
+        if (!s->batch_path) prompt();
+    }
+
+    if (s->batch_path) {
+        scheduler_next(s);
+    }
+}
+
+/* Control Socket */
+
+/**
+ * Disconnect client and release its buffers.
+ **/
+void client_close(EventLoop *l, Client *c) {
+    for (Client **p = &PQShellClients; *p; p = &(*p)->next) {
+        if (*p == c) {
+            *p = c->next;
+            break;
+        }
+    }
+
+    event_loop_unwatch(l, c->fd);
+    close(c->fd);
+    free(c->output);
+    free(c);
+}
+
+/**
+ * Queue reply for client.
+ * @return  Whether or not there was memory for the reply.
+ **/
+bool client_reply(Client *c, const char *data, size_t size) {
+    if (c->pending + size > c->capacity) {
+        size_t capacity = max(c->capacity * 2, c->pending + size);
+        char  *output   = realloc(c->output, capacity);
+        if (!output) {
+            return false;
+        }
+        c->output   = output;
+        c->capacity = capacity;
+    }
+    memcpy(c->output + c->pending, data, size);
+    c->pending += size;
+    return true;
+}
+
+/**
+ * Write as many queued replies as the socket accepts, and only wait for the
+ * socket to become writable while some remain.
+ * @return  Whether or not the client is still connected.
+ **/
+bool client_flush(EventLoop *l, Client *c) {
+    size_t written = 0;
+    while (written < c->pending) {
+        ssize_t nwritten = send(c->fd, c->output + written, c->pending - written, MSG_NOSIGNAL);
+        if (nwritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nwritten < 0 && errno == EAGAIN) {
+            break;
+        }
+        if (nwritten <= 0) {                                                    // client went away
+            client_close(l, c);
+            return false;
+        }
+        written += nwritten;
+    }
+
+    memmove(c->output, c->output + written, c->pending - written);
+    c->pending -= written;
+
+    if (c->closing && !c->pending) {
+        client_close(l, c);
+        return false;
+    }
+    event_loop_modify(l, c->fd, (c->closing ? 0 : EPOLLIN) | (c->pending ? EPOLLOUT : 0));
+    return true;
+}
+
+/**
+ * Read commands from client and queue their replies.
+ *
+ * Every complete line in a read is executed before the replies are written,
+ * so a client streaming thousands of adds costs one write per read rather
+ * than one per job.
+ **/
+void client_handler(EventLoop *l, int fd, uint32_t events, void *arg) {
+    Scheduler *s = &PQShellScheduler;
+    Client    *c = arg;
+
+    if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !c->closing) {
+        ssize_t nread = read(fd, c->input + c->length, sizeof(c->input) - c->length - 1);
+        if (nread < 0 && (errno == EINTR || errno == EAGAIN)) {
+            return;
+        }
+
+        char  *replies = NULL;
+        size_t size    = 0;
+        FILE  *fs      = open_memstream(&replies, &size);
+        if (!fs) {
+            client_close(l, c);
+            return;
+        }
+
+        if (nread <= 0) {                                                       // EOF: execute partial line
+            c->input[c->length] = 0;
+            if (c->length) {
+                execute(s, fs, c->input);
+            }
+            c->closing = true;
+        } else {
+            c->length += nread;
+            c->input[c->length] = 0;
+
+            char *line = c->input;
+            char *newline;
+            while (!c->closing && (newline = memchr(line, '\n', c->length - (line - c->input)))) {
+                *newline = 0;
+                c->closing = !execute(s, fs, line);
+                line = newline + 1;
+            }
+
+            c->length -= line - c->input;
+            memmove(c->input, line, c->length);
+            if (c->length == sizeof(c->input) - 1) {                            // line too long: execute what we have
+                c->input[c->length] = 0;
+                c->length  = 0;
+                c->closing = c->closing || !execute(s, fs, c->input);
+            }
+        }
+
+        fclose(fs);
+        bool queued = client_reply(c, replies, size);
+        free(replies);
+        if (!queued) {
+            client_close(l, c);
+            return;
+        }
+        batch_check(l, s);
+    }
+
+    if (events & EPOLLOUT) {                                                    // replies are otherwise sent once committed
+        client_flush(l, c);
+    }
+}
+
+/**
+ * Move output of jobs into their log files or ring buffers.
+ **/
+void output_handler(EventLoop *l, int fd, uint32_t events, void *arg) {
+    Scheduler *s = arg;
+    capture_drain(&s->capture);
+}
+
+/**
+ * Accept every pending client connection.
+ **/
+void accept_handler(EventLoop *l, int fd, uint32_t events, void *arg) {
+    int client_fd;
+
+    while ((client_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        Client *c = calloc(1, sizeof(Client));
+        if (!c) {
+            close(client_fd);
+            continue;
+        }
+
+        c->fd = client_fd;
+        if (!event_loop_watch(l, client_fd, EPOLLIN, client_handler, c)) {
+            close(client_fd);
+            free(c);
+            continue;
+        }
+        c->next        = PQShellClients;
+        PQShellClients = c;
+    }
+}
+
+/**
+ * After each batch of events: commit the journal once for everything the
+ * batch appended (group commit), then send replies that acknowledge it.
+ **/
+void idle_handler(EventLoop *l, int fd, uint32_t events, void *arg) {
+    Scheduler *s = arg;
+
+    journal_commit(&s->journal);
+    for (Client *next, *c = PQShellClients; c; c = next) {
+        next = c->next;
+        if (c->pending || c->closing) {
+            client_flush(l, c);
+        }
+    }
+}
+
+/**
+ * SIGINT or SIGTERM: shut down cleanly (terminating launched jobs, which
+ * are resumed first if paused, and removing the socket).
+ **/
+void term_handler(EventLoop *l, int fd, uint32_t events, void *arg) {
+    signal_drain(fd);
+    event_loop_stop(l);
 }
 
 /* Main Execution */
 
 int main(int argc, char *argv[]) {
     Scheduler *s = &PQShellScheduler;
+    EventLoop *l = &PQShellLoop;
+    int status   = EXIT_FAILURE;
+    int child_fd = -1;
+    int timer_fd = -1;
+    int control_fd = -1;
+    int int_fd   = -1;
+    int term_fd  = -1;
+    Time start;
 
-    /* TODO: Parse command line options */
-    if(!parse_command_line_options(argc,argv,s)) {
-        return EXIT_FAILURE; 
-    }
-
-    /* TODO: Register signal handlers */
-    signal_register(SIGALRM,0,sigalrm_handler);
-
-    /* TODO: Start timer interrupt */
-    struct itimerval interval = {                                                           // struct variable for timer interrupt
-        .it_interval = { .tv_sec = 0, .tv_usec = s->timeout },                              // set interval equal to timeout set by user
-        .it_value    = { .tv_sec = 0, .tv_usec = s->timeout },
-    };
-    if (setitimer(ITIMER_REAL, &interval, NULL) < 0) {
-        return EXIT_FAILURE;                                                                // returns error if error
-    }
-
-
-    /* TODO: Process shell comands */
-    while (!feof(stdin)) {                                                                  // reads user input until quit | exit 
-        char command[BUFSIZ]  = "";
-        char argument[BUFSIZ] = "";
-
-        printf("\nPQSH> ");                                                                
-
-        while (!fgets(command, BUFSIZ, stdin) && !feof(stdin));                             // gets each user command and saves it to comman 
-
-        chomp(command);                                                                     // removes trailing newline
-        
-        /* TODO: Handle add and status commands */
-        if (streq(command, "help")) {                                                       // if command is help, show help 
-            help();
-        } else if (strstr(command, "add") != NULL) {                                        // if user wats to add a process  
-            // argument = strchr(command,(int)" ");                                         // returns pointer to string after the word add
-            if(strlen(command) > strlen("add")) {
-                for(int i = strlen("add"); i < strlen(command) - strlen("add"); i++){       // places the rest of the string into the argument string
-                    argument[i - strlen("add")+1] = command[i];
-                }
-                scheduler_add(s,stdout,argument);                                           // add system argument to scheduler
-                fprintf(stdout,"Added process -%s- to waiting queue",command); 
-            } else help();                                                                  //  tried to add nothing 
-        } else if(strstr(command, "status") != NULL) {                                      // if status is in the command string
-            int queue = 0;                                                                      // value for which queue to pass into the status call 
-            if(strstr(command, "running") != NULL) queue = RUNNING;
-            else if(strstr(command,"waiting") != NULL) queue = WAITING;
-            else if (strstr(command,"finished") != NULL)queue = FINISHED;
-            scheduler_status(s,stdout,queue);                                                // send to scheduler status 
-        } else if (streq(command, "exit") || streq(command, "quit")) {                      // if exit | quit, break from while loop 
-            break;
-        } else if (strlen(command)) {                                                       // if command is unknown 
-            printf("Unknown command: %s\n", command);
+    if (!parse_command_line_options(argc, argv, s)) {
+        return EXIT_FAILURE;
+    }
+
+    if (!scheduler_init(s)) {
+        error("Unable to initialize scheduler");
+        scheduler_release(s);
+        return EXIT_FAILURE;
+    }
+
+    /* Learned run time estimates persist across runs */
+    char history_path[BUFSIZ];
+    if (!s->history_path && s->policy == SRTF_POLICY && getenv("HOME")) {
+        snprintf(history_path, BUFSIZ, "%s/%s", getenv("HOME"), HISTORY_FILE);
+        s->history_path = history_path;
+    }
+    if (s->history_path && !history_load(&s->history, s->history_path)) {
+        error("Unable to load history from %s", s->history_path);
+    }
+
+    if (s->trace_path && !trace_init(&s->trace, TRACE_CAPACITY)) {
+        error("Unable to allocate trace buffer");
+        goto cleanup;
+    }
+
+    /* Jobs that were waiting (or running) when a previous shell died are queued again */
+    if (s->journal_path && !scheduler_recover(s)) {
+        goto cleanup;
+    }
+
+    if (!event_loop_init(l)) {
+        goto cleanup;
+    }
+    event_loop_idle(l, idle_handler, s);
+
+    /* Child exits, timer interrupts, and shell input are all events */
+    child_fd = signal_open(SIGCHLD);
+    timer_fd = event_timer_open(s->timeout);
+    if (child_fd < 0 || timer_fd < 0) {
+        goto cleanup;
+    }
+
+    if (!event_loop_watch(l, child_fd, EPOLLIN, child_handler, s) ||
+        !event_loop_watch(l, timer_fd, EPOLLIN, timer_handler, s)) {
+        goto cleanup;
+    }
+
+    /* Job output is drained from its pipe, never written to the terminal */
+    if (s->capture.fd >= 0 && !event_loop_watch(l, s->capture.fd, EPOLLIN, output_handler, s)) {
+        goto cleanup;
+    }
+
+    /* SIGINT and SIGTERM stop the loop, so jobs are not orphaned (stopped, even) */
+    int_fd  = signal_open(SIGINT);
+    term_fd = signal_open(SIGTERM);
+    if (int_fd < 0 || term_fd < 0 ||
+        !event_loop_watch(l, int_fd, EPOLLIN, term_handler, s) ||
+        !event_loop_watch(l, term_fd, EPOLLIN, term_handler, s)) {
+        goto cleanup;
+    }
+
+    /* Local clients submit over the control socket until SIGINT or SIGTERM */
+    if (s->socket_path) {
+        control_fd = control_open(s->socket_path);
+        if (control_fd < 0 || !event_loop_watch(l, control_fd, EPOLLIN, accept_handler, s)) {
+            goto cleanup;
         }
+    }
 
+    /* Batch files (and stdin redirected from a file) are enqueued in one pass */
+    struct stat st;
+    bool detached = s->socket_path && !isatty(STDIN_FILENO) &&                  // e.g. daemon with stdin from /dev/null
+                    (fstat(STDIN_FILENO, &st) < 0 || !S_ISFIFO(st.st_mode));
+    start          = timestamp();
+    PQShellExecute = s->batch_path ? batch_execute : execute;
+    if (s->batch_path && !streq(s->batch_path, "-")) {
+        FILE *fs = fopen(s->batch_path, "r");
+        if (!fs) {
+            error("Unable to open %s: %s", s->batch_path, strerror(errno));
+            goto cleanup;
+        }
+        batch_load(s, fs);
+        fclose(fs);
+    } else if (s->batch_path && fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode)) {
+        batch_load(s, stdin);
+    } else if (!detached && !event_loop_watch(l, STDIN_FILENO, EPOLLIN, input_handler, s)) {
+        goto cleanup;
+    }
+
+    if (s->batch_path) {
         scheduler_next(s);
-        scheduler_wait(s); 
+        event_loop_run(l);
+        status = batch_summary(s, stdout, timestamp() - start) ? EXIT_FAILURE : EXIT_SUCCESS;
+    } else {
+        scheduler_next(s);
+        if (!detached) prompt();
+        event_loop_run(l);
+        status = EXIT_SUCCESS;
     }
 
-    return EXIT_SUCCESS;
+cleanup:
+    scheduler_shutdown(s);                                                      // launched jobs exit (and are journaled) with the shell
+    if (s->metrics_path) {
+        scheduler_export(s, s->metrics_path);
+    }
+    if (s->trace_path && s->trace.events) {
+        trace_flush(&s->trace, s->trace_path);
+    }
+    if (s->history_path) {
+        history_save(&s->history, s->history_path);
+    }
+    while (PQShellClients) {
+        client_close(l, PQShellClients);
+    }
+    if (control_fd >= 0) {
+        close(control_fd);
+        unlink(s->socket_path);
+    }
+    scheduler_release(s);
+    event_loop_release(l);
+    if (child_fd >= 0) close(child_fd);
+    if (timer_fd >= 0) close(timer_fd);
+    if (int_fd >= 0) close(int_fd);
+    if (term_fd >= 0) close(term_fd);
+    return status;
 }
 
 /* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
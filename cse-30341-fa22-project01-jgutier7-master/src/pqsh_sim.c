@@ -0,0 +1,95 @@
+/* pqsh_sim.c: Process Queue Shell Simulator */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/options.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/simulator.h"
+#include "../include/pqsh/timestamp.h"
+
+#include <errno.h>
+#include <string.h>
+
+/* Global Variables */
+
+Scheduler PQSimScheduler = {
+    .policy    = FIFO_POLICY,
+    .cores     = 1,
+    .timeout   = 250000,
+    .launch    = LAUNCH_SIMULATE,
+    .levels    = 3,
+    .boost     = 1000000,
+};
+
+Simulator PQSimSimulator;
+
+/* Main Execution */
+
+int main(int argc, char *argv[]) {
+    Scheduler *s   = &PQSimScheduler;
+    Simulator *sim = &PQSimSimulator;
+    int status     = EXIT_FAILURE;
+
+    if (!parse_command_line_options(argc, argv, s)) {
+        return EXIT_FAILURE;
+    }
+    s->launch = LAUNCH_SIMULATE;                                                // -L is meaningless here
+
+    if (!s->batch_path) {
+        fprintf(stderr, "Usage: %s -f TRACE [options]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!scheduler_init(s)) {
+        error("Unable to initialize scheduler");
+        goto cleanup;
+    }
+
+    /* Learned estimates are only loaded when requested (and never saved), so runs are reproducible */
+    if (s->history_path && !history_load(&s->history, s->history_path)) {
+        error("Unable to load history from %s", s->history_path);
+    }
+
+    FILE *fs = streq(s->batch_path, "-") ? stdin : fopen(s->batch_path, "r");
+    if (!fs) {
+        error("Unable to open %s: %s", s->batch_path, strerror(errno));
+        goto cleanup;
+    }
+    bool loaded = simulator_load(sim, fs);
+    if (fs != stdin) {
+        fclose(fs);
+    }
+    if (!loaded) {
+        goto cleanup;
+    }
+
+    if (s->trace_path && !trace_init(&s->trace, TRACE_CAPACITY)) {
+        error("Unable to allocate trace buffer");
+        goto cleanup;
+    }
+
+    Time   start = timestamp();
+    bool   done  = simulator_run(sim, s);
+    double wall  = time_to_seconds(timestamp() - start);
+
+    printf("Jobs = %lu, Makespan = %.2lf, Throughput = %.2lf jobs/s, Turnaround = %.2lf, Response = %.2lf, Wait = %.2lf\n",
+        sim->finished, sim->now, sim->now > 0 ? sim->finished / sim->now : 0.0,
+        time_to_seconds(histogram_mean(&s->turnaround)), time_to_seconds(histogram_mean(&s->response)),
+        time_to_seconds(histogram_mean(&s->wait)));
+    scheduler_stats(s, stdout);
+    fprintf(stderr, "Simulated %lu jobs in %.2lf seconds\n", sim->size, wall);
+
+    if (s->metrics_path) {
+        scheduler_export(s, s->metrics_path);
+    }
+    if (s->trace_path && s->trace.events) {
+        trace_flush(&s->trace, s->trace_path);
+    }
+    status = done ? EXIT_SUCCESS : EXIT_FAILURE;
+
+cleanup:
+    scheduler_release(s);
+    simulator_release(sim);
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,115 @@
+/* pqsh_submit.c: Process Queue Shell Submission Client */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/control.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/* Functions */
+
+void usage(const char *program) {
+    fprintf(stderr, "Usage: %s -S PATH [command...]\n\n", program);
+    fprintf(stderr, "Send command (or every line of stdin) to pqsh listening on PATH and print replies.\n\n");
+    fprintf(stderr, "Examples:\n");
+    fprintf(stderr, "    %s -S /run/pqsh.sock add sleep 10\n", program);
+    fprintf(stderr, "    %s -S /run/pqsh.sock status running\n", program);
+    fprintf(stderr, "    sed 's/^/add /' jobs.txt | %s -S /run/pqsh.sock\n", program);
+}
+
+/**
+ * Write entire buffer to file descriptor.
+ * @return  Whether or not everything was written.
+ **/
+bool write_all(int fd, const char *data, size_t size) {
+    while (size) {
+        ssize_t nwritten = write(fd, data, size);
+        if (nwritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nwritten <= 0) {
+            return false;
+        }
+        data += nwritten;
+        size -= nwritten;
+    }
+    return true;
+}
+
+/**
+ * Send commands to socket: the command line if given, otherwise stdin.
+ * @return  Whether or not every command was sent.
+ **/
+bool submit(int fd, int argc, char *argv[]) {
+    char buffer[BUFSIZ];
+
+    if (argc) {
+        for (int i = 0; i < argc; i++) {
+            if (!write_all(fd, argv[i], strlen(argv[i])) || !write_all(fd, i + 1 < argc ? " " : "\n", 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ssize_t nread;
+    while ((nread = read(STDIN_FILENO, buffer, BUFSIZ)) != 0) {
+        if (nread < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nread < 0 || !write_all(fd, buffer, nread)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Main Execution */
+
+int main(int argc, char *argv[]) {
+    const char *path = NULL;
+    int argind       = 1;
+
+    while (argind < argc && argv[argind][0] == '-' && strlen(argv[argind]) > 1) {
+        char *arg = argv[argind++];
+        if (streq(arg, "-S") && argind < argc) {
+            path = argv[argind++];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!path) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int fd = control_connect(path);
+    if (fd < 0) {
+        error("Unable to connect to %s: %s", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    /* The shell buffers replies, so send everything before reading any */
+    bool sent = submit(fd, argc - argind, argv + argind);
+    shutdown(fd, SHUT_WR);
+
+    char    buffer[BUFSIZ];
+    ssize_t nread;
+    while ((nread = read(fd, buffer, BUFSIZ)) != 0) {
+        if (nread < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nread < 0 || !write_all(STDOUT_FILENO, buffer, nread)) {
+            break;
+        }
+    }
+
+    close(fd);
+    return sent ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
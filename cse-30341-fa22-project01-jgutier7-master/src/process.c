@@ -1,61 +1,300 @@
 /* process.c: PQSH Process */
 
+#define _GNU_SOURCE
+
 #include "../include/pqsh/macros.h"
+#include "../include/pqsh/capture.h"
+#include "../include/pqsh/intern.h"
 #include "../include/pqsh/process.h"
+#include "../include/pqsh/slab.h"
 #include "../include/pqsh/timestamp.h"
 
 #include <errno.h>
 #include <limits.h>
+#include <sched.h>
 #include <signal.h>
+#include <spawn.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 
+/* Globals */
+
+static Slab ProcessSlab = SLAB_INITIALIZER(Process);    /* Pool of Process records */
+
+/**
+ * Split command into an argument vector, honoring shell-style quoting:
+ *
+ *  - Whitespace separates arguments.
+ *  - 'single quotes' preserve everything literally.
+ *  - "double quotes" preserve everything except backslash escaped \\ and ".
+ *  - A backslash outside quotes escapes the next character.
+ *
+ * The vector and its strings are stored in a single allocation.
+ *
+ * @param   command     String with command to parse.
+ * @return  NULL-terminated argument vector (NULL on error or empty command).
+ **/
+char **process_parse(const char *command) {
+    size_t length = strlen(command);
+    size_t argc   = 0;
+
+    /* Each argument needs at least one character plus a separator */
+    size_t slots  = length / 2 + 2;
+    char **argv   = malloc(slots * sizeof(char *) + length + 1);
+    if (!argv) {
+        return NULL;
+    }
+
+    char *buffer  = (char *)(argv + slots);
+    char *out     = buffer;
+    const char *in = command;
+
+    while (*in) {
+        while (*in == ' ' || *in == '\t') in++;
+        if (!*in) {
+            break;
+        }
+
+        argv[argc++] = out;
+        char quote   = 0;
+        while (*in && (quote || (*in != ' ' && *in != '\t'))) {
+            if (quote == '\'') {
+                if (*in == '\'') quote = 0;
+                else *out++ = *in;
+                in++;
+            } else if (*in == '\\' && in[1] && (!quote || in[1] == '"' || in[1] == '\\')) {
+                *out++ = in[1];
+                in += 2;
+            } else if (*in == '"' || (*in == '\'' && !quote)) {
+                quote = quote ? 0 : *in;
+                in++;
+            } else {
+                *out++ = *in++;
+            }
+        }
+        *out++ = 0;
+
+        if (quote || argc >= MAX_ARGUMENTS) {
+            free(argv);
+            return NULL;
+        }
+    }
+
+    if (!argc) {
+        free(argv);
+        return NULL;
+    }
+    argv[argc] = NULL;
+    return argv;
+}
+
 /**
  * Create new process structure given command.
+ *
+ * Processes are drawn from a slab and share both the interned command string
+ * and its parsed argument vector with every other process running the same
+ * command.
+ *
  * @param   command     String with command to execute.
  * @return  Pointer to new process structure
  **/
 Process *process_create(const char *command) {
-    /* TODO: Implement */
-    Process *new_process = calloc(1, sizeof(Process));         // allocate pointer 
+    Process *new_process = slab_alloc(&ProcessSlab);           // allocate zeroed record from pool
     if(!new_process) return NULL;                              // return if fails
-    if(!strcpy(new_process->command,command)) return NULL;     // copy command into new_process->commamnd
+    new_process->command = intern_acquire(command);            // share identical command strings
+    if (!new_process->command) {
+        slab_free(&ProcessSlab, new_process);
+        return NULL;
+    }
+
+    InternString *entry = intern_entry(new_process->command);
+    if (!entry->argv) {
+        entry->argv = process_parse(command);                  // tokenize once per distinct command
+    }
+    if (!entry->argv) {
+        process_delete(new_process);
+        return NULL;
+    }
+    new_process->argv = entry->argv;
     new_process->arrival_time = timestamp();                   // set time for when it arrives in waiting queue 
+    new_process->weight  = 1;
+    new_process->tickets = TICKETS_DEFAULT;
+    new_process->core    = -1;
+    new_process->cpu     = -1;
     return new_process;                                        // returns new_process
 }
 
+/**
+ * Release process structure.
+ * @param   p           Pointer to Process structure.
+ **/
+void process_delete(Process *p) {
+    if (p) {
+        capture_close(p->output);
+        intern_release(p->command);
+        slab_free(&ProcessSlab, p);
+    }
+}
+
+/**
+ * Return number of live process structures.
+ **/
+size_t process_count(void) {
+    return ProcessSlab.used;
+}
+
+/**
+ * Release pool of process structures once none are live.
+ **/
+void process_trim(void) {
+    slab_trim(&ProcessSlab);
+}
+
+/**
+ * Restrict process to a single CPU.
+ * @param   pid         Process identifier (0 == calling process).
+ * @param   cpu         CPU to pin to (-1 == leave affinity unchanged).
+ * @return  Whether or not the affinity was set successfully.
+ **/
+static bool process_pin(pid_t pid, int cpu) {
+    if (cpu < 0) {
+        return true;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(pid, sizeof(set), &set) < 0) {
+        if (pid) {
+            error("Unable to pin process %d to CPU %d: %s", pid, cpu, strerror(errno));
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Launch process using posix_spawn (which clones without copying the parent's
+ * page tables), pinning it afterwards if required.
+ * @param   p           Pointer to Process structure.
+ * @return  Whether or not the process was spawned.
+ **/
+static bool process_spawn(Process *p) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t          mask;
+    int               status;
+
+    sigemptyset(&mask);
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    posix_spawn_file_actions_init(&actions);
+    if (p->output) {                                                                            // stdout and stderr into capture pipe
+        posix_spawn_file_actions_adddup2(&actions, p->output->sink, STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, p->output->sink, STDERR_FILENO);
+    }
+
+    status = posix_spawnp(&p->pid, p->argv[0], &actions, &attr, p->argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    if (status != 0) {
+        error("Unable to posix_spawnp %s: %s", p->argv[0], strerror(status));
+        p->pid = 0;
+        return false;
+    }
+
+    process_pin(p->pid, p->cpu);
+    return true;
+}
+
+/**
+ * Launch process using fork or vfork and execvp.
+ *
+ * The child only touches its own stack and makes system calls, which keeps
+ * it safe to run in the parent's address space under vfork.
+ *
+ * @param   p           Pointer to Process structure.
+ * @param   mode        LAUNCH_FORK or LAUNCH_VFORK.
+ * @return  Whether or not the child was created.
+ **/
+static bool process_fork(Process *p, LaunchMode mode) {
+    static const char failure[] = "Unable to execvp\n";
+    sigset_t mask;
+    pid_t    pid;
+    int      sink = p->output ? p->output->sink : -1;
+
+    sigemptyset(&mask);
+    pid = (mode == LAUNCH_VFORK) ? vfork() : fork();
+    switch (pid) {
+        case -1:                                                                                // unsuccessful fork
+            error("Unable to fork: %s", strerror(errno));
+            return false;
+        case  0:                                                                                // child
+            sigprocmask(SIG_SETMASK, &mask, NULL);                                              // restore signals blocked by the event loop
+            process_pin(0, p->cpu);
+            if (sink >= 0) {                                                                    // stdout and stderr into capture pipe
+                dup2(sink, STDOUT_FILENO);
+                dup2(sink, STDERR_FILENO);
+            }
+            execvp(p->argv[0], p->argv);
+            if (write(STDERR_FILENO, failure, sizeof(failure) - 1) < 0) {}
+            _exit(EXIT_FAILURE);                                                                // never return into the shell's event loop
+        default:                                                                                // Parent (Success)
+            p->pid = pid;
+            return true;
+    }
+}
+
+/**
+ * Start process by launching the command with the specified mechanism.
+ * @param   p           Pointer to Process structure.
+ * @param   mode        Launch mechanism.
+ * @return  Whether or not starting the process was successful
+ **/
+bool process_launch(Process *p, LaunchMode mode) {
+    static pid_t simulated = 0;
+    bool started;
+
+    switch (mode) {
+        case LAUNCH_SPAWN:      started = process_spawn(p); break;
+        case LAUNCH_SIMULATE:   p->pid  = ++simulated; started = true; break;
+        default:                started = process_fork(p, mode); break;
+    }
+    if (started) {
+        p->start_time = timestamp();                                                            // update timestamp for when process starts
+    }
+    return started;
+}
+
 /**
  * Start process by forking and executing the command.
  * @param   p           Pointer to Process structure.
  * @return  Whether or not starting the process was successful
  **/
 bool process_start(Process *p) {
-    /* TODO: Implement */
-    p->pid = fork();                                                                            // fork()
-    char *argv[MAX_ARGUMENTS] = {NULL};                                                         // char *argv[MAX_ARGUMENTS] = {0}
-    int i = 0;                                                                                  // counter for argument 
-    switch (p->pid) {
-        case -1:                                                                                // unsuccessful fork
-            fprintf(stderr, "Unable to fork: %s\n", strerror(errno));                           // prints to stderr
-            return false;                                                                       // returns false
-        case  0:;                                                                               // child
-            if(p->command) {
-                for (char *token = strtok(p->command, " "); token; token = strtok(NULL, " ")){  // parses command, spltting using \space as a delimiter 
-                    argv[i] = token;                                                            // argv[i] = token; 
-                    i++;                                                                        // increment 
-                }
-                if (!execvp(argv[0],argv)) {                                                    // executes command, arguments
-                    fprintf(stderr, "Unable to execvp: %s\n", strerror(errno));
-                    return false;                                                               // returns with false if execvp fails
-                }
-            } else return false;
-            break;
-        default:                                                                                // Parent (Success)
-            p->start_time = timestamp();                                                        // update timestamp for when process starts                                   
-            break;                                                                              
-    } 
+    return process_launch(p, LAUNCH_FORK);
+}
 
+/**
+ * Return launch mode with the specified name.
+ * @param   name        Name of launch mode (fork, vfork, spawn).
+ * @param   mode        Where to store launch mode.
+ * @return  Whether or not the name was recognized.
+ **/
+bool process_launch_mode(const char *name, LaunchMode *mode) {
+    if (streq(name, "fork")) {
+        *mode = LAUNCH_FORK;
+    } else if (streq(name, "vfork")) {
+        *mode = LAUNCH_VFORK;
+    } else if (streq(name, "spawn")) {
+        *mode = LAUNCH_SPAWN;
+    } else {
+        return false;
+    }
     return true;
 }
 
@@ -77,8 +316,28 @@ bool process_pause(Process *p) {
  **/
 bool process_resume(Process *p) {                                                                // use SIGCONT signal 
     /* TODO: Implement */
+    process_pin(p->pid, p->cpu);                                                                 // may have been assigned a different core
     if(!kill(p->pid, SIGCONT)) return true;
     return false; 
 }
 
+/**
+ * Write column headers for process_dump to stream.
+ * @param   fs          Output file stream.
+ **/
+void process_dump_header(FILE *fs) {
+    fprintf(fs, "%6s %-30s %-13s %-13s %-13s\n", 
+                "PID", "COMMAND", "ARRIVAL", "START", "END");
+}
+
+/**
+ * Write process information to stream.
+ * @param   p           Pointer to Process structure.
+ * @param   fs          Output file stream.
+ **/
+void process_dump(Process *p, FILE *fs) {
+    fprintf(fs, "%6d %-30s %-13.2f %-13.2f %-13.2f\n", (int)p->pid, p->command,
+        timestamp_wall(p->arrival_time), timestamp_wall(p->start_time), timestamp_wall(p->end_time));
+}
+
 /* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
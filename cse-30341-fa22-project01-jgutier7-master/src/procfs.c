@@ -0,0 +1,146 @@
+/* procfs.c: PQSH Linux /proc Readers */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/procfs.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Read small /proc file into buffer (NUL terminated).
+ * @param   path        Path of file.
+ * @param   buffer      Buffer to read into.
+ * @param   size        Size of buffer.
+ * @return  Whether or not anything was read.
+ **/
+static bool procfs_read(const char *path, char *buffer, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    ssize_t nread = read(fd, buffer, size - 1);
+    close(fd);
+    if (nread <= 0) {
+        return false;
+    }
+    buffer[nread] = 0;
+    return true;
+}
+
+/**
+ * Read total time some task stalled on resource (Linux PSI).
+ * @param   resource    Resource name (cpu, memory, io).
+ * @param   stalled     Where to store total stall time.
+ * @return  Whether or not pressure information is available.
+ **/
+bool procfs_pressure(const char *resource, Time *stalled) {
+    char path[BUFSIZ];
+    char buffer[BUFSIZ];
+    unsigned long total;
+
+    snprintf(path, BUFSIZ, "%s/pressure/%s", PROCFS_ROOT, resource);
+    if (!procfs_read(path, buffer, BUFSIZ)) {
+        return false;
+    }
+
+    char *field = strstr(buffer, "total=");                         // first line is "some"
+    if (!field || sscanf(field, "total=%lu", &total) != 1) {
+        return false;
+    }
+    *stalled = total * NSEC_PER_USEC;
+    return true;
+}
+
+/**
+ * Read memory available for new processes without swapping.
+ * @param   bytes       Where to store available memory (bytes).
+ * @return  Whether or not MemAvailable was found.
+ **/
+bool procfs_available(size_t *bytes) {
+    char buffer[BUFSIZ];
+    unsigned long kilobytes;
+
+    if (!procfs_read(PROCFS_ROOT "/meminfo", buffer, BUFSIZ)) {
+        return false;
+    }
+
+    char *field = strstr(buffer, "MemAvailable:");
+    if (!field || sscanf(field, "MemAvailable: %lu kB", &kilobytes) != 1) {
+        return false;
+    }
+    *bytes = kilobytes * 1024;
+    return true;
+}
+
+/**
+ * Read resident set size of process.
+ * @param   pid         Process identifier.
+ * @param   rss         Where to store resident set size (bytes).
+ * @return  Whether or not the process exists.
+ **/
+bool procfs_statm(pid_t pid, size_t *rss) {
+    char path[BUFSIZ];
+    char buffer[BUFSIZ];
+    unsigned long pages;
+
+    snprintf(path, BUFSIZ, "%s/%d/statm", PROCFS_ROOT, (int)pid);
+    if (!procfs_read(path, buffer, BUFSIZ) || sscanf(buffer, "%*u %lu", &pages) != 1) {
+        return false;
+    }
+    *rss = pages * sysconf(_SC_PAGESIZE);
+    return true;
+}
+
+/**
+ * Read scheduling state and CPU time of process.
+ * @param   pid         Process identifier.
+ * @param   state       Where to store state (R, S, D, T, Z, ...).
+ * @param   cpu_time    Where to store user plus system time.
+ * @return  Whether or not the process exists.
+ **/
+bool procfs_stat(pid_t pid, char *state, Time *cpu_time) {
+    char path[BUFSIZ];
+    char buffer[BUFSIZ];
+    unsigned long user, system;
+
+    snprintf(path, BUFSIZ, "%s/%d/stat", PROCFS_ROOT, (int)pid);
+    if (!procfs_read(path, buffer, BUFSIZ)) {
+        return false;
+    }
+
+    char *fields = strrchr(buffer, ')');                            // command may contain spaces and parentheses
+    if (!fields || sscanf(fields + 1, " %c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+            state, &user, &system) != 3) {
+        return false;
+    }
+    *cpu_time = (Time)(user + system) * NSEC_PER_SEC / sysconf(_SC_CLK_TCK);
+    return true;
+}
+
+/**
+ * Read context switches of process so far.
+ * @param   pid         Process identifier.
+ * @param   voluntary   Where to store switches while waiting on resources.
+ * @param   involuntary Where to store switches due to preemption by the kernel.
+ * @return  Whether or not both counts were found.
+ **/
+bool procfs_switches(pid_t pid, long *voluntary, long *involuntary) {
+    char path[BUFSIZ];
+    char buffer[BUFSIZ];
+
+    snprintf(path, BUFSIZ, "%s/%d/status", PROCFS_ROOT, (int)pid);
+    if (!procfs_read(path, buffer, BUFSIZ)) {
+        return false;
+    }
+
+    char *field = strstr(buffer, "\nvoluntary_ctxt_switches:");
+    if (!field || sscanf(field, " voluntary_ctxt_switches: %ld nonvoluntary_ctxt_switches: %ld",
+            voluntary, involuntary) != 2) {
+        return false;
+    }
+    return true;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
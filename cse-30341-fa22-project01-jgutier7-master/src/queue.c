@@ -10,10 +10,40 @@
  * @param q     Pointer to Queue structure.
  **/
 void        queue_push(Queue *q, Process *p) {
-    /* TODO: Implement */
-    if(q->size==0) q->head = p;                                                     // if first item, make it head
-    else q->tail = p;                                                               // else, places process as the tail of the queue
-    (q->size)++;                                                                    // updates the size of the queue  
+    p->next  = NULL;
+    p->prev  = q->tail;
+    p->queue = q;
+    if (q->tail) {
+        q->tail->next = p;
+    } else {
+        q->head = p;
+    }
+    q->tail = p;
+    q->size++;
+}
+
+/**
+ * Insert process into queue in front of another.
+ * @param q         Pointer to Queue structure.
+ * @param p         Pointer to Process to insert.
+ * @param before    Pointer to Process in queue (NULL == push to back).
+ **/
+void        queue_insert(Queue *q, Process *p, Process *before) {
+    if (!before) {
+        queue_push(q, p);
+        return;
+    }
+
+    p->next  = before;
+    p->prev  = before->prev;
+    p->queue = q;
+    if (before->prev) {
+        before->prev->next = p;
+    } else {
+        q->head = p;
+    }
+    before->prev = p;
+    q->size++;
 }
 
 /**
@@ -22,37 +52,56 @@ void        queue_push(Queue *q, Process *p) {
  * @return  Process from front of queue.
  **/
 Process *   queue_pop(Queue *q) {
-    /* TODO: Implement */
-    if(q->size == 0) return NULL;
-    Process *head = q->head;                                                        // places current head in a placeholder to return       
-    (q->head)++;                                                                    // set head to the next item in the queue
-    (q->size)--;                                                                    // updates the size of the queue   
-    return head;                                                                    // returns popped item
+    Process *head = q->head;
+    if (!head) {
+        return NULL;
+    }
 
+    queue_unlink(head);
+    return head;
 }
 
 /**
- * Remove and return process with specified pid.
+ * Remove and return process with specified pid (by scanning the queue; use
+ * queue_unlink when the Process is already known).
  * @param q     Pointer to Queue structure.
  * @param pid   Pid of process to return.
  * @return  Process from Queue with specified pid.
  **/
 Process *   queue_remove(Queue *q, pid_t pid) {
-    /* TODO: Implement */
-    if(!pid) return NULL;                                                            // returns if pid is NULL 
-    for(Process *p = q->head; p; p++){                                               // loop through each process in queue
-        if(p->pid == pid){                                                           // if pid is found
-            if(p == q->head){                                                        // if process is head 
-                (q->head)++;                                                         // sets new head
-            } else if (p == q->tail){                                                // if it's the tail
-                (q->tail)--;                                                         // set tail pointer to the next to last item in queue 
-            }
-
-            (q->size)--;                                                             // updates size of queue
-            return p;                                                                // returns found process 
+    if (!pid) return NULL;
+    for (Process *p = q->head; p; p = p->next) {
+        if (p->pid == pid) {
+            queue_unlink(p);
+            return p;
         }
-    } 
-    return NULL;                                                                     // returns NULL if PID is not found in queue
+    }
+    return NULL;
+}
+
+/**
+ * Remove process from whichever queue contains it in constant time.
+ * @param p     Pointer to Process structure.
+ **/
+void        queue_unlink(Process *p) {
+    Queue *q = p->queue;
+    if (!q) return;
+
+    if (p->prev) {
+        p->prev->next = p->next;
+    } else {
+        q->head = p->next;
+    }
+    if (p->next) {
+        p->next->prev = p->prev;
+    } else {
+        q->tail = p->prev;
+    }
+
+    p->next  = NULL;
+    p->prev  = NULL;
+    p->queue = NULL;
+    q->size--;
 }
 
 /**
@@ -61,14 +110,10 @@ Process *   queue_remove(Queue *q, pid_t pid) {
  * @param fs    Output file stream.
  **/
 void        queue_dump(Queue *q, FILE *fs) {
-    if(q->size == 0) return;                                        // returns if queue is empty
-    fprintf(fs, "%6s %-30s %-13s %-13s %-13s\n", 
-                "PID", "COMMAND", "ARRIVAL", "START", "END");
-    /* TODO: Display information for each item in Queue. */
-    int i = 0;
-    for(Process *p = q->head; i < q->size; i++){
-        fprintf(fs, "%6d %-30s %-13.2f %-13.2f %-13.2f\n", (int)p->pid, p->command, p->arrival_time, p->start_time, p->end_time);
-        p++;
+    if (q->size == 0) return;
+    process_dump_header(fs);
+    for (Process *p = q->head; p; p = p->next) {
+        process_dump(p, fs);
     }
 }
 
@@ -0,0 +1,309 @@
+/* rbtree.c: PQSH Red-Black Tree */
+
+#include "../include/pqsh/rbtree.h"
+
+/* Rotations */
+
+static void rbtree_rotate_left(RBTree *t, RBNode *x) {
+    RBNode *y = x->right;
+
+    x->right = y->left;
+    if (y->left) {
+        y->left->parent = x;
+    }
+
+    y->parent = x->parent;
+    if (!x->parent) {
+        t->root = y;
+    } else if (x == x->parent->left) {
+        x->parent->left = y;
+    } else {
+        x->parent->right = y;
+    }
+
+    y->left   = x;
+    x->parent = y;
+}
+
+static void rbtree_rotate_right(RBTree *t, RBNode *x) {
+    RBNode *y = x->left;
+
+    x->left = y->right;
+    if (y->right) {
+        y->right->parent = x;
+    }
+
+    y->parent = x->parent;
+    if (!x->parent) {
+        t->root = y;
+    } else if (x == x->parent->right) {
+        x->parent->right = y;
+    } else {
+        x->parent->left = y;
+    }
+
+    y->right  = x;
+    x->parent = y;
+}
+
+/**
+ * Replace subtree rooted at u with subtree rooted at v.
+ **/
+static void rbtree_transplant(RBTree *t, RBNode *u, RBNode *v) {
+    if (!u->parent) {
+        t->root = v;
+    } else if (u == u->parent->left) {
+        u->parent->left = v;
+    } else {
+        u->parent->right = v;
+    }
+
+    if (v) {
+        v->parent = u->parent;
+    }
+}
+
+static bool rbtree_is_red(RBNode *n) {
+    return n && n->red;
+}
+
+/**
+ * Insert node into tree (equal keys are placed after existing ones).
+ * @param   t           Pointer to RBTree structure.
+ * @param   n           Pointer to RBNode to insert.
+ * @param   compare     Function that orders two nodes.
+ **/
+void rbtree_insert(RBTree *t, RBNode *n, RBCompare compare) {
+    RBNode  *parent   = NULL;
+    RBNode **link     = &t->root;
+    bool     leftmost = true;
+
+    while (*link) {
+        parent = *link;
+        if (compare(n, parent) < 0) {
+            link = &parent->left;
+        } else {
+            link = &parent->right;
+            leftmost = false;
+        }
+    }
+
+    n->parent = parent;
+    n->left   = NULL;
+    n->right  = NULL;
+    n->red    = true;
+    *link     = n;
+
+    if (leftmost) {
+        t->first = n;
+    }
+    t->size++;
+
+    /* Restore red-black properties */
+    RBNode *p;
+    while ((p = n->parent) && p->red) {
+        RBNode *g = p->parent;
+
+        if (p == g->left) {
+            RBNode *u = g->right;
+            if (rbtree_is_red(u)) {
+                p->red = u->red = false;
+                g->red = true;
+                n = g;
+            } else {
+                if (n == p->right) {
+                    rbtree_rotate_left(t, p);
+                    n = p;
+                    p = n->parent;
+                }
+                p->red = false;
+                g->red = true;
+                rbtree_rotate_right(t, g);
+            }
+        } else {
+            RBNode *u = g->left;
+            if (rbtree_is_red(u)) {
+                p->red = u->red = false;
+                g->red = true;
+                n = g;
+            } else {
+                if (n == p->left) {
+                    rbtree_rotate_right(t, p);
+                    n = p;
+                    p = n->parent;
+                }
+                p->red = false;
+                g->red = true;
+                rbtree_rotate_left(t, g);
+            }
+        }
+    }
+    t->root->red = false;
+}
+
+/**
+ * Restore red-black properties after removing a black node.
+ * @param   t           Pointer to RBTree structure.
+ * @param   x           Node that replaced the removed node (may be NULL).
+ * @param   parent      Parent of x.
+ **/
+static void rbtree_remove_fixup(RBTree *t, RBNode *x, RBNode *parent) {
+    while (x != t->root && !rbtree_is_red(x)) {
+        if (x == parent->left) {
+            RBNode *w = parent->right;
+            if (w->red) {
+                w->red      = false;
+                parent->red = true;
+                rbtree_rotate_left(t, parent);
+                w = parent->right;
+            }
+
+            if (!rbtree_is_red(w->left) && !rbtree_is_red(w->right)) {
+                w->red = true;
+                x      = parent;
+                parent = x->parent;
+            } else {
+                if (!rbtree_is_red(w->right)) {
+                    w->left->red = false;
+                    w->red       = true;
+                    rbtree_rotate_right(t, w);
+                    w = parent->right;
+                }
+                w->red      = parent->red;
+                parent->red = false;
+                if (w->right) {
+                    w->right->red = false;
+                }
+                rbtree_rotate_left(t, parent);
+                x = t->root;
+            }
+        } else {
+            RBNode *w = parent->left;
+            if (w->red) {
+                w->red      = false;
+                parent->red = true;
+                rbtree_rotate_right(t, parent);
+                w = parent->left;
+            }
+
+            if (!rbtree_is_red(w->left) && !rbtree_is_red(w->right)) {
+                w->red = true;
+                x      = parent;
+                parent = x->parent;
+            } else {
+                if (!rbtree_is_red(w->left)) {
+                    w->right->red = false;
+                    w->red        = true;
+                    rbtree_rotate_left(t, w);
+                    w = parent->left;
+                }
+                w->red      = parent->red;
+                parent->red = false;
+                if (w->left) {
+                    w->left->red = false;
+                }
+                rbtree_rotate_right(t, parent);
+                x = t->root;
+            }
+        }
+    }
+
+    if (x) {
+        x->red = false;
+    }
+}
+
+/**
+ * Remove node from tree.
+ * @param   t           Pointer to RBTree structure.
+ * @param   z           Pointer to RBNode to remove (must be in tree).
+ **/
+void rbtree_remove(RBTree *t, RBNode *z) {
+    RBNode *y      = z;
+    RBNode *x      = NULL;
+    RBNode *parent = NULL;
+    bool    y_red  = y->red;
+
+    if (t->first == z) {
+        t->first = rbtree_next(z);
+    }
+
+    if (!z->left) {
+        x      = z->right;
+        parent = z->parent;
+        rbtree_transplant(t, z, z->right);
+    } else if (!z->right) {
+        x      = z->left;
+        parent = z->parent;
+        rbtree_transplant(t, z, z->left);
+    } else {
+        y = z->right;
+        while (y->left) {
+            y = y->left;
+        }
+        y_red = y->red;
+        x     = y->right;
+
+        if (y->parent == z) {
+            parent = y;
+        } else {
+            parent = y->parent;
+            rbtree_transplant(t, y, y->right);
+            y->right = z->right;
+            y->right->parent = y;
+        }
+
+        rbtree_transplant(t, z, y);
+        y->left = z->left;
+        y->left->parent = y;
+        y->red = z->red;
+    }
+
+    if (!y_red) {
+        rbtree_remove_fixup(t, x, parent);
+    }
+
+    z->parent = z->left = z->right = NULL;
+    t->size--;
+}
+
+/**
+ * Return minimum node in tree (NULL if empty).
+ * @param   t           Pointer to RBTree structure.
+ **/
+RBNode *rbtree_first(RBTree *t) {
+    return t->first;
+}
+
+/**
+ * Return maximum node in tree (NULL if empty).
+ * @param   t           Pointer to RBTree structure.
+ **/
+RBNode *rbtree_last(RBTree *t) {
+    RBNode *n = t->root;
+    while (n && n->right) {
+        n = n->right;
+    }
+    return n;
+}
+
+/**
+ * Return in-order successor of node (NULL if last).
+ * @param   n           Pointer to RBNode structure.
+ **/
+RBNode *rbtree_next(RBNode *n) {
+    if (n->right) {
+        n = n->right;
+        while (n->left) {
+            n = n->left;
+        }
+        return n;
+    }
+
+    while (n->parent && n == n->parent->right) {
+        n = n->parent;
+    }
+    return n->parent;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
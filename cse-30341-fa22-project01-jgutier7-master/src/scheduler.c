@@ -1,25 +1,362 @@
 /* scheduler.c: PQSH Scheduler */
 
+#define _GNU_SOURCE
+
 #include "../include/pqsh/macros.h"
+#include "../include/pqsh/intern.h"
 #include "../include/pqsh/scheduler.h"
 #include "../include/pqsh/timestamp.h"
 #include "../include/pqsh/process.h"
+#include "../include/pqsh/procfs.h"
 
 #include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 
+/**
+ * Allocate per-core state once the number of cores is known.
+ * @param   s	    Pointer to Scheduler structure.
+ * @return  Whether or not allocation was successful.
+ **/
+bool scheduler_init(Scheduler *s) {
+    s->slice = s->timeout;
+    s->limit = s->cores;
+    s->capture.fd = -1;
+    if (!s->seed) {
+        s->seed = LOTTERY_SEED;
+    }
+    if ((s->capture.directory || s->capture.size) && s->launch != LAUNCH_SIMULATE && !capture_init(&s->capture)) {
+        return false;
+    }
+    s->slots = calloc(s->cores, sizeof(Process *));
+    if (!s->slots) {
+        return false;
+    }
+
+    if (s->affinity) {
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) < 0) {
+            error("Unable to get CPU affinity: %s", strerror(errno));
+            return false;
+        }
+
+        s->runqueues = calloc(s->cores, sizeof(Queue));
+        s->cpus      = calloc(CPU_COUNT(&set), sizeof(int));
+        if (!s->runqueues || !s->cpus) {
+            return false;
+        }
+
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                s->cpus[s->ncpus++] = cpu;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Release all processes and scheduler state.
+ * @param   s	    Pointer to Scheduler structure.
+ **/
+void scheduler_release(Scheduler *s) {
+    Process *p;
+
+    while ((p = queue_pop(&s->running)))  process_delete(p);
+    while ((p = queue_pop(&s->waiting)))  process_delete(p);
+    while ((p = queue_pop(&s->blocked)))  process_delete(p);
+    while ((p = queue_pop(&s->finished))) process_delete(p);
+    for (size_t level = 0; level < MLFQ_MAX_LEVELS; level++) {
+        while ((p = queue_pop(&s->level[level]))) process_delete(p);
+    }
+    for (size_t core = 0; s->runqueues && core < s->cores; core++) {
+        while ((p = queue_pop(&s->runqueues[core]))) process_delete(p);
+    }
+    while (s->tree.size) {
+        RBNode *n = rbtree_first(&s->tree);
+        rbtree_remove(&s->tree, n);
+        process_delete(container_of(n, Process, node));
+    }
+    while (s->lottery.size) {
+        p = s->lottery.entries[0];
+        lottery_remove(&s->lottery, p);
+        process_delete(p);
+    }
+    for (size_t i = 0; i < s->ntenants; i++) {
+        while ((p = queue_pop(&s->tenants[i]->waiting))) process_delete(p);
+        intern_release(s->tenants[i]->name);
+        free(s->tenants[i]);
+    }
+
+    journal_close(&s->journal);
+    capture_release(&s->capture);
+    dag_release(&s->dag);
+    history_release(&s->history);
+    lottery_release(&s->lottery);
+    pidmap_release(&s->pids);
+    trace_release(&s->trace);
+    free(s->tenants);
+    free(s->slots);
+    free(s->runqueues);
+    free(s->cpus);
+    s->tenants   = NULL;
+    s->ntenants  = 0;
+    s->slots     = NULL;
+    s->runqueues = NULL;
+    s->cpus      = NULL;
+    s->ncpus     = 0;
+    process_trim();                                             // pool is kept across jobs until shutdown
+}
+
+/**
+ * Send signal to every launched process that has not been reaped.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   signum  Signal to send.
+ **/
+static void scheduler_signal(Scheduler *s, int signum) {
+    for (size_t i = 0; i < s->pids.capacity; i++) {
+        if (s->pids.entries[i].pid) {
+            kill(s->pids.entries[i].pid, signum);
+        }
+    }
+}
+
+/**
+ * Terminate launched jobs that have not finished and reap them, so their
+ * exits are journaled and a restarted shell does not run them again.
+ *
+ * Paused jobs are continued so they act on SIGTERM, and jobs still alive
+ * after SHUTDOWN_LIMIT are killed. Jobs that never started are left waiting
+ * (the next shell recovers them from the journal).
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ **/
+void scheduler_shutdown(Scheduler *s) {
+    sigset_t mask, saved;
+    int      signum = SIGTERM;
+
+    if (s->launch == LAUNCH_SIMULATE || !s->pids.size) {
+        return;
+    }
+
+    /* Exits after each reap stay pending until sigtimedwait */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &saved);
+
+    scheduler_signal(s, SIGTERM);
+    scheduler_signal(s, SIGCONT);
+    Time deadline = timestamp() + SHUTDOWN_LIMIT;
+    while (scheduler_wait(s), s->pids.size) {
+        Time left = deadline - timestamp();
+        if (left <= 0) {
+            if (signum == SIGKILL) {
+                error("Unable to terminate %lu processes", s->pids.size);
+                break;
+            }
+            signum = SIGKILL;
+            scheduler_signal(s, SIGKILL);
+            deadline = timestamp() + SHUTDOWN_LIMIT;
+            continue;
+        }
+        struct timespec timeout = { .tv_sec = left / NSEC_PER_SEC, .tv_nsec = left % NSEC_PER_SEC };
+        sigtimedwait(&mask, NULL, &timeout);
+    }
+
+    sigprocmask(SIG_SETMASK, &saved, NULL);
+}
+
 /**
  * Add new command to waiting queue.
+ *
+ * The command may be preceded by job options:
+ *
+ *  -w WEIGHT       Share weight for the completely fair policy (default 1).
+ *  -t TICKETS      Share for the lottery and stride policies (default TICKETS_DEFAULT).
+ *  --deadline SECONDS  Finish within SECONDS of arrival (earliest deadline first).
+ *  --tenant NAME   Tenant sharing cores with other tenants (fair).
+ *  --id NAME       Name job so later jobs can depend on it.
+ *  --after NAMES   Comma separated jobs that must finish first (repeatable).
+ *  --              End of options.
+ *
+ * Jobs with unfinished dependencies wait in the blocked queue. Jobs whose
+ * dependency failed are cancelled (finished with exit status DAG_CANCELLED
+ * without running).
+ *
  * @param   s	    Pointer to Scheduler structure.
- * @param   fs      File stream to write to.
+ * @param   fs      File stream to write to (NULL == only report errors, to stderr).
  * @param   command Command string for new Process.
+ * @return  Pointer to new Process (NULL if it was not added).
  **/
-void scheduler_add(Scheduler *s, FILE *fs, const char *command) {
-    /* TODO: Implement */ 
-    Process *p = process_create(command);
-    queue_push(&(s->waiting), p);
+Process *scheduler_add(Scheduler *s, FILE *fs, const char *command) {
+    FILE  *es = fs ? fs : stderr;
+    char   flag[BUFSIZ];
+    char   value[BUFSIZ];
+    char   id[BUFSIZ]   = "";
+    char   tenant[BUFSIZ] = "";
+    int    consumed     = 0;
+    double weight       = 1;
+    long   tickets      = TICKETS_DEFAULT;
+    double deadline     = 0;
+    DagNode **after     = NULL;
+    size_t    nafter    = 0;
+    Process  *p         = NULL;
+
+    while (*command == '-') {
+        if (strncmp(command, "--", 2) == 0 && (command[2] == ' ' || !command[2])) {
+            for (command += 2; *command == ' '; command++);
+            break;
+        }
+
+        if (sscanf(command, "%s %s %n", flag, value, &consumed) < 2) {
+            fprintf(es, "Missing value for option: %s\n", command);
+            goto cleanup;
+        }
+
+        if (streq(flag, "-w")) {
+            weight = atof(value);
+            if (weight <= 0) {
+                fprintf(es, "Invalid weight: %s\n", value);
+                goto cleanup;
+            }
+        } else if (streq(flag, "-t")) {
+            tickets = atol(value);
+            if (tickets <= 0) {
+                fprintf(es, "Invalid tickets: %s\n", value);
+                goto cleanup;
+            }
+        } else if (streq(flag, "--deadline")) {
+            deadline = atof(value);
+            if (deadline <= 0) {
+                fprintf(es, "Invalid deadline: %s\n", value);
+                goto cleanup;
+            }
+        } else if (streq(flag, "--tenant")) {
+            strcpy(tenant, value);
+        } else if (streq(flag, "--id")) {
+            if (dag_find(&s->dag, value)) {
+                fprintf(es, "Duplicate job id: %s\n", value);
+                goto cleanup;
+            }
+            strcpy(id, value);
+        } else if (streq(flag, "--after")) {
+            for (char *name = strtok(value, ","); name; name = strtok(NULL, ",")) {
+                DagNode *n = dag_find(&s->dag, name);
+                if (!n) {
+                    fprintf(es, "Unknown dependency: %s\n", name);
+                    goto cleanup;
+                }
+                DagNode **grown = realloc(after, (nafter + 1) * sizeof(DagNode *));
+                if (!grown) {
+                    goto cleanup;
+                }
+                after = grown;
+                after[nafter++] = n;
+            }
+        } else {
+            fprintf(es, "Unknown option: %s\n", flag);
+            goto cleanup;
+        }
+        command += consumed;
+    }
+
+    p = process_create(command);
+    if (!p) {
+        fprintf(es, "Unable to add process: %s\n", command);
+        goto cleanup;
+    }
+    p->weight  = weight;
+    p->tickets = tickets;
+
+    if (*tenant && !(p->tenant = scheduler_tenant(s, tenant))) {   // only create tenants of accepted jobs
+        fprintf(es, "Unable to add tenant: %s\n", tenant);
+        process_delete(p);
+        p = NULL;
+        goto cleanup;
+    }
+
+    if (*id || nafter) {
+        double cost = history_estimate(&s->history, p->command);
+        p->dag = dag_add(&s->dag, p, *id ? id : NULL, after, nafter, cost > 0 ? cost : DAG_DEFAULT_COST);
+        if (!p->dag) {
+            fprintf(es, "Unable to add process: %s\n", command);
+            process_delete(p);
+            p = NULL;
+            goto cleanup;
+        }
+    }
+
     p->arrival_time = timestamp();
-    
+    if (deadline > 0) {
+        p->deadline = p->arrival_time + time_from_seconds(deadline);
+    }
+    trace_record(&s->trace, TRACE_ARRIVAL, p, -1, p->arrival_time);
+    scheduler_journal_add(s, p);
+    if (p->dag && p->dag->failed) {
+        scheduler_cancel(s, p);
+    } else if (p->dag && p->dag->pending) {
+        queue_push(&s->blocked, p);
+    } else {
+        scheduler_ready(s, p);
+    }
+    if (fs) {
+        fprintf(fs, "Added process \"%s\" to %s queue.\n", command,
+            p->queue == &s->blocked ? "blocked" : (p->queue == &s->finished ? "finished" : "waiting"));
+    }
+
+cleanup:
+    free(after);
+    return p;
+}
+
+/**
+ * Place runnable process in the waiting queue, ahead of every process with a
+ * shorter critical path (processes outside any dependency graph have none,
+ * so they keep arrival order).
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to Process (not in any queue).
+ **/
+void scheduler_ready(Scheduler *s, Process *p) {
+    double   rank   = p->dag ? p->dag->rank : 0;
+    Process *before = NULL;
+
+    for (Process *q = s->waiting.tail; q && (q->dag ? q->dag->rank : 0) < rank; q = q->prev) {
+        before = q;
+    }
+    queue_insert(&s->waiting, p, before);
+}
+
+/**
+ * Finish process without running it because a dependency failed.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to Process (not in any queue).
+ **/
+void scheduler_cancel(Scheduler *s, Process *p) {
+    p->end_time = timestamp();
+    p->status   = W_EXITCODE(DAG_CANCELLED, 0);
+    trace_record(&s->trace, TRACE_EXIT, p, -1, p->end_time);
+    scheduler_finish(s, p);
+}
+
+/**
+ * Return number of processes waiting in any policy structure.
+ * @param   s	    Pointer to Scheduler structure.
+ **/
+size_t scheduler_waiting(Scheduler *s) {
+    size_t waiting = s->waiting.size + s->blocked.size + s->tree.size + s->lottery.size;
+    for (size_t level = 0; level < s->levels; level++) {
+        waiting += s->level[level].size;
+    }
+    for (size_t core = 0; s->runqueues && core < s->cores; core++) {
+        waiting += s->runqueues[core].size;
+    }
+    for (size_t i = 0; i < s->ntenants; i++) {
+        waiting += s->tenants[i]->waiting.size;
+    }
+    return waiting;
 }
 
 /**
@@ -30,25 +367,115 @@ void scheduler_add(Scheduler *s, FILE *fs, const char *command) {
  **/
 void scheduler_status(Scheduler *s, FILE *fs, int queue) {
     /* Display status of specified queue (default is all) */
+    size_t waiting = scheduler_waiting(s);
+
     fprintf(fs, "Running = %4lu, Waiting = %4lu, Finished = %4lu, Turnaround = %05.2lf, Response = %05.2lf\n",
-        (s->running).size, (s->waiting).size, (s->finished).size,s->total_turnaround_time, s->total_response_time);
+        (s->running).size, waiting, (s->finished).size,
+        s->turnaround.count ? time_to_seconds(s->total_turnaround_time) / s->turnaround.count : 0.0,
+        s->response.count ? time_to_seconds(s->total_response_time) / s->response.count : 0.0);
 
-    /* TODO: Complement implementation. */
-    if(queue == 0 || queue == RUNNING) {
+    if (s->deadlines) {
+        fprintf(fs, "Deadlines = %4lu, Met = %5.1lf%%, Lateness P50 = %.3lf, P99 = %.3lf, Max = %.3lf\n",
+            s->deadlines, 100.0 * (s->deadlines - s->deadline_misses) / s->deadlines,
+            time_to_seconds(histogram_percentile(&s->lateness, 50)),
+            time_to_seconds(histogram_percentile(&s->lateness, 99)), time_to_seconds(s->lateness.max));
+    }
+
+    if (queue == STATS) {
+        scheduler_stats(s, fs);
+        return;
+    }
 
-        fprintf(fs, "Running Queue:\n");
+    if ((queue == 0 || queue == RUNNING) && s->running.size) {
+        fprintf(fs, "\nRunning Queue:\n");
         queue_dump(&s->running,fs);
     } 
     if (queue == 0 || queue == WAITING) {
-        fprintf(fs, "Waiting Queue:\n");
-        queue_dump(&s->waiting,fs);
+        if (s->waiting.size) {
+            fprintf(fs, "\nWaiting Queue:\n");
+            queue_dump(&s->waiting,fs);
+        }
+        for (size_t level = 0; level < s->levels; level++) {
+            if (s->level[level].size) {
+                fprintf(fs, "\nWaiting Queue (Level %lu):\n", level);
+                queue_dump(&s->level[level], fs);
+            }
+        }
+        for (size_t core = 0; s->runqueues && core < s->cores; core++) {
+            if (s->runqueues[core].size) {
+                fprintf(fs, "\nWaiting Queue (Core %lu):\n", core);
+                queue_dump(&s->runqueues[core], fs);
+            }
+        }
+        for (size_t i = 0; i < s->ntenants; i++) {
+            if (s->tenants[i]->waiting.size) {
+                fprintf(fs, "\nWaiting Queue (Tenant %s):\n", s->tenants[i]->name);
+                queue_dump(&s->tenants[i]->waiting, fs);
+            }
+        }
+        if (s->blocked.size) {
+            fprintf(fs, "\nBlocked Queue:\n");
+            queue_dump(&s->blocked, fs);
+        }
+        if (s->tree.size) {
+            fprintf(fs, "\nWaiting Tree:\n");
+            process_dump_header(fs);
+            for (RBNode *n = rbtree_first(&s->tree); n; n = rbtree_next(n)) {
+                process_dump(container_of(n, Process, node), fs);
+            }
+        }
+        if (s->lottery.size) {
+            fprintf(fs, "\nWaiting Lottery (%lu tickets):\n", s->lottery.total);
+            process_dump_header(fs);
+            for (size_t i = 0; i < s->lottery.size; i++) {
+                process_dump(s->lottery.entries[i], fs);
+            }
+        }
     } 
-    if (queue == 0 || queue == FINISHED) {
-        fprintf(fs, "Finished Queue:\n");
+    if ((queue == 0 || queue == FINISHED) && s->finished.size) {
+        fprintf(fs, "\nFinished Queue:\n");
         queue_dump(&s->finished,fs);
     }
-    
+}
+
+/**
+ * Display job with process identifier and its captured output.
+ *
+ * Pids are reused, so a live process wins over finished ones, and among
+ * finished ones the most recent wins. The output shown is that job's own
+ * (each log file is named after its process's pid and start time).
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   fs      File stream to write to.
+ * @param   pid     Process identifier.
+ * @return  Whether or not the job was found.
+ **/
+bool scheduler_output(Scheduler *s, FILE *fs, pid_t pid) {
+    Process *p = pid > 0 ? scheduler_find(s, pid) : NULL;
+    for (Process *f = s->finished.tail; pid > 0 && f && !p; f = f->prev) {   // most recent exit first
+        if (f->pid == pid) {
+            p = f;
+        }
+    }
+    if (!p) {
+        fprintf(fs, "Unknown process: %d\n", pid);
+        return false;
+    }
+
+    process_dump_header(fs);
+    process_dump(p, fs);
+    if (!p->output) {
+        fprintf(fs, "\nOutput not captured (start pqsh with -O DIRECTORY or -R BYTES)\n");
+        return true;
+    }
 
+    capture_read(&s->capture, p->output, CAPTURE_QUANTUM);
+    if (p->output->path) {
+        fprintf(fs, "\nLog: %s\n", p->output->path);
+    }
+    fprintf(fs, "\nOutput (%lu bytes%s):\n", p->output->bytes, p->output->fd >= 0 ? ", open" : "");
+    capture_dump(&s->capture, p->output, fs);
+    return true;
 }
 
 /**
@@ -57,39 +484,287 @@ void scheduler_status(Scheduler *s, FILE *fs, int queue) {
  **/
 void scheduler_next(Scheduler *s) {
     /* TODO: Dispatch to appropriate scheduler function. */
-    if(s->policy == FIFO_POLICY) {                                          // if scheduler is fifo policy, send to fifo scheduler 
-        scheduler_fifo(s);
-    } else {                                                                // else: the user wants RDRN scheduling 
-        scheduler_rdrn(s);
+    switch (s->policy) {
+        case FIFO_POLICY:    scheduler_fifo(s);    break;
+        case RDRN_POLICY:    scheduler_rdrn(s);    break;
+        case MLFQ_POLICY:    scheduler_mlfq(s);    break;
+        case CFS_POLICY:     scheduler_cfs(s);     break;
+        case SRTF_POLICY:    scheduler_srtf(s);    break;
+        case LOTTERY_POLICY: scheduler_lottery(s); break;
+        case STRIDE_POLICY:  scheduler_stride(s);  break;
+        case EDF_POLICY:     scheduler_edf(s);     break;
+        case FAIR_POLICY:    scheduler_fair(s);    break;
     }
-    
 }
 
 /**
  * Wait for any children and remove from queues and update metrics.
+ *
+ * When instrumenting, stops of paused children are collected here too, so
+ * stop latency is measured without blocking the pause.
+ *
  * @param   s	    Pointer to Scheduler structure.
+ * @return  Number of children reaped.
  **/
-void scheduler_wait(Scheduler *s) {
+size_t scheduler_wait(Scheduler *s) {
+    size_t reaped = 0;
     pid_t pid;
+    int   status;
+    int   flags = WNOHANG | (s->instrument ? WUNTRACED : 0);       // also collect stops of paused processes
+    struct rusage usage;
     /* TODO: Wait for any children without blocking:
      *
      *  - Remove process from queues.
      *  - Update Process metrics.
      *  - Update Scheduler metrics.
      **/
-    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+    while ((pid = wait4(-1, &status, flags, &usage)) > 0) {
         /* remove process from queues */
-        Process *found = queue_remove(&s->running, pid);
+        Process *found = pidmap_find(&s->pids, pid);
+        if (!found) {
+            continue;
+        }
+        if (WIFSTOPPED(status)) {
+            scheduler_switch_stopped(s, found, timestamp());
+            continue;
+        }
 
-        /* update process metrics */
-        found->end_time = timestamp();                              // end time
-        
-        /* update scheduler metrics */
-        queue_push(&s->finished,found);                             // push process to the finished queue
-        s->total_turnaround_time = found->end_time - found->arrival_time;                    
- 
+        /* update process and scheduler metrics */
+        scheduler_exit(s, found, status, &usage);
+        reaped++;
+    }
+    return reaped;
+}
 
+/**
+ * Remove exited process from whichever structure holds it, update its
+ * metrics, and place it in the finished queue.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to launched Process.
+ * @param   status  Wait status of process.
+ * @param   usage   Resource usage of process (NULL == unknown).
+ **/
+void scheduler_exit(Scheduler *s, Process *p, int status, const struct rusage *usage) {
+    bool running = p->queue == &s->running;
+
+    pidmap_remove(&s->pids, p->pid);
+    if (p->output) {
+        capture_read(&s->capture, p->output, CAPTURE_QUANTUM);     // whatever it wrote before exiting
+    }
+    p->status   = status;
+    p->end_time = timestamp();                                      // end time
+    if (usage) {
+        if (s->instrument) {
+            scheduler_switch_sample(s, p, usage->ru_nvcsw, usage->ru_nivcsw);
+        }
+        p->user_time            = usage->ru_utime.tv_sec * NSEC_PER_SEC + usage->ru_utime.tv_usec * NSEC_PER_USEC;
+        p->system_time          = usage->ru_stime.tv_sec * NSEC_PER_SEC + usage->ru_stime.tv_usec * NSEC_PER_USEC;
+        p->max_rss              = usage->ru_maxrss;
+        p->voluntary_switches   = usage->ru_nvcsw;
+        p->involuntary_switches = usage->ru_nivcsw;
+    }
+    if (p->queue) {
+        queue_unlink(p);
+    } else if (p->node.parent || s->tree.root == &p->node) {
+        rbtree_remove(&s->tree, &p->node);                          // paused job killed while waiting
+    } else if (lottery_contains(&s->lottery, p)) {
+        lottery_remove(&s->lottery, p);
+    }
+
+    trace_record(&s->trace, TRACE_EXIT, p, running ? p->core : -1, p->end_time);
+
+    if (running) {
+        if (p->core >= 0 && s->slots) {
+            s->slots[p->core] = NULL;
+        }
+        p->run_time += p->end_time - p->dispatch_time;
+    }
+    if (s->policy == SRTF_POLICY || s->history_path) {
+        history_update(&s->history, p->command, time_to_seconds(p->run_time));
+    }
+
+    scheduler_finish(s, p);
+}
+
+/**
+ * Record metrics of completed process and place it in the finished queue.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to Process (not in any queue).
+ **/
+void scheduler_finish(Scheduler *s, Process *p) {
+    Time turnaround = p->end_time - p->arrival_time;
+
+    s->total_turnaround_time += turnaround;
+    histogram_record(&s->turnaround, turnaround);
+    histogram_record(&s->wait, turnaround - p->run_time);           // runnable but not running
+    if (p->tenant) {
+        p->tenant->finished++;
+        p->tenant->run_time += p->run_time;
+    }
+    if (p->deadline) {
+        s->deadlines++;
+        s->deadline_misses += p->end_time > p->deadline;
+        histogram_record(&s->lateness, max(p->end_time - p->deadline, 0));
+    }
+    if (s->overhead > 0 && p->pid) {
+        scheduler_slice_burst(s, p->run_time);
+    }
+    queue_push(&s->finished, p);
+    scheduler_journal_finish(s, p);
+    if (p->dag) {
+        scheduler_unblock(s, p->dag, !WIFEXITED(p->status) || WEXITSTATUS(p->status));
+    }
+}
+
+/**
+ * Release dependents of finished job that are no longer blocked, and cancel
+ * them if the job failed.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   n       Pointer to DagNode of finished job.
+ * @param   failed  Whether or not the job failed.
+ **/
+void scheduler_unblock(Scheduler *s, DagNode *n, bool failed) {
+    n->finished = true;
+    n->failed  |= failed;
+
+    for (size_t i = 0; i < n->ndependents; i++) {
+        DagNode *d = n->dependents[i];
+        Process *p = d->process;
+
+        d->pending--;
+        d->failed |= n->failed;
+        if (!p || p->queue != &s->blocked || (d->pending && !d->failed)) {
+            continue;
+        }
+
+        queue_unlink(p);
+        if (d->failed) {
+            scheduler_cancel(s, p);
+        } else {
+            scheduler_ready(s, p);
+        }
+    }
+}
+
+/**
+ * Return launched process that has not been reaped yet.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   pid     Process identifier.
+ * @return  Pointer to Process (NULL if not found).
+ **/
+Process *scheduler_find(Scheduler *s, pid_t pid) {
+    return pidmap_find(&s->pids, pid);
+}
+
+/**
+ * Return whether running process is blocked (sleeping or in uninterruptible
+ * I/O), sampling its state and CPU time from /proc.
+ *
+ * Simulated processes are not sampled: their state is set by the owner.
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to running Process.
+ * @return  Whether or not the process is sleeping.
+ **/
+bool scheduler_sleeping(Scheduler *s, Process *p) {
+    if (s->launch != LAUNCH_SIMULATE && !procfs_stat(p->pid, &p->state, &p->cpu_time)) {
+        p->state = 0;                                               // exited but not reaped yet
+    }
+    return p->state == 'S' || p->state == 'D';
+}
+
+/**
+ * Start or resume waiting process and place it in the running queue.
+ *
+ * A process that cannot be started is placed in the finished queue.
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to waiting Process (not in any queue).
+ * @return  Whether or not the process is now running.
+ **/
+bool scheduler_dispatch(Scheduler *s, Process *p) {
+    Time now = timestamp();
+
+    /* Prefer the core the process last ran on */
+    if (s->slots) {
+        if (p->core < 0 || (size_t)p->core >= s->cores || s->slots[p->core]) {
+            p->core = -1;
+            for (size_t core = 0; core < s->cores && p->core < 0; core++) {
+                if (!s->slots[core]) {
+                    p->core = core;
+                }
+            }
+        }
+        if (p->core >= 0) {
+            s->slots[p->core] = p;
+        }
+        p->cpu = (s->affinity && s->ncpus && p->core >= 0) ? s->cpus[p->core % s->ncpus] : -1;
+    }
+
+    if (p->pid == 0) {
+        if (s->capture.fd >= 0 && !(p->output = capture_open(&s->capture))) {
+            error("Unable to capture output of process: %s", p->command);
+        }
+        if (!process_launch(p, s->launch)) {
+            error("Unable to start process: %s", p->command);
+            capture_close(p->output);
+            p->output = NULL;
+            if (p->core >= 0 && s->slots) {
+                s->slots[p->core] = NULL;
+            }
+            p->end_time = now;
+            p->status   = W_EXITCODE(127, 0);                       // like a shell's command not found
+            trace_record(&s->trace, TRACE_EXIT, p, -1, now);
+            scheduler_finish(s, p);
+            return false;
+        }
+        if (!pidmap_insert(&s->pids, p->pid, p)) {
+            error("Unable to index process %d", p->pid);
+        }
+        if (p->output) {
+            capture_start(&s->capture, p->output, p->pid);
+        }
+        s->total_response_time += p->start_time - p->arrival_time;
+        histogram_record(&s->response, p->start_time - p->arrival_time);
+        trace_record(&s->trace, TRACE_START, p, p->core, now);
+    } else {
+        if (s->launch != LAUNCH_SIMULATE && !process_resume(p)) {
+            error("Unable to resume process %d", p->pid);
+        } else if (s->instrument && s->launch != LAUNCH_SIMULATE) {
+            scheduler_switch_resume(s, p, now);
+        }
+        trace_record(&s->trace, TRACE_RESUME, p, p->core, now);
+    }
+
+    p->dispatch_time = now;
+    queue_push(&s->running, p);
+    s->dispatches++;
+    return true;
+}
+
+/**
+ * Pause running process and remove it from the running queue.
+ *
+ * The caller is responsible for placing the process in a waiting structure.
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to running Process.
+ **/
+void scheduler_preempt(Scheduler *s, Process *p) {
+    Time now = timestamp();
+
+    queue_unlink(p);
+    if (p->core >= 0 && s->slots) {
+        s->slots[p->core] = NULL;
+    }
+    if (s->launch != LAUNCH_SIMULATE && !process_pause(p)) {
+        error("Unable to pause process %d", p->pid);
+    } else if (s->instrument && s->launch != LAUNCH_SIMULATE) {
+        scheduler_switch_pause(s, p, now);
     }
+    trace_record(&s->trace, TRACE_PAUSE, p, p->core, now);
+    p->run_time += now - p->dispatch_time;
+    s->preemptions++;
 }
 
 /* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
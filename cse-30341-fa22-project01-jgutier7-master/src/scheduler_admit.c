@@ -0,0 +1,98 @@
+/* scheduler_admit.c: PQSH Admission Control */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/procfs.h"
+#include "../include/pqsh/timestamp.h"
+
+/**
+ * Adjust the number of processes allowed to run at once:
+ *
+ *  1. Memory pressure above the limit, or too little available memory for
+ *  another job of the usual size, holds waiting jobs (the limit drops to the
+ *  number already running, but never below one so the queue drains).
+ *
+ *  2. Otherwise a limit below cores grows back by one per sample.
+ *
+ *  3. CPU pressure, or running jobs using more than every core, shrinks a
+ *  raised limit back towards cores by one per sample.
+ *
+ *  4. If every allowed job is running but together they use less than
+ *  ADMIT_IDLE of the cores (they are mostly blocked on I/O), the limit grows
+ *  by one per sample, up to ADMIT_SCALE jobs per core.
+ *
+ * @param   s	        Pointer to Scheduler structure.
+ * @param   memory      Fraction of last period some task stalled on memory.
+ * @param   cpu         Fraction of last period some task waited for a CPU.
+ * @param   usage       CPUs used by running jobs over last period.
+ * @param   available   Memory available without swapping (bytes, 0 == unknown).
+ **/
+void scheduler_admit_update(Scheduler *s, double memory, double cpu, double usage, size_t available) {
+    s->memory_pressure = memory;
+    s->cpu_pressure    = cpu;
+    s->usage           = usage;
+
+    if (memory > s->memory_limit || (available && available < s->job_rss * ADMIT_HEADROOM)) {
+        s->limit = max(min(s->limit, s->running.size), (size_t)1);
+        s->holds++;
+    } else if (s->limit < s->cores) {
+        s->limit++;
+    } else if (cpu > ADMIT_CPU_PRESSURE || usage > s->cores) {
+        s->limit = max(s->limit - 1, s->cores);
+    } else if (s->running.size >= s->limit && usage < s->cores * ADMIT_IDLE && s->limit < s->cores * ADMIT_SCALE) {
+        s->limit++;
+    }
+}
+
+/**
+ * Sample pressure and running jobs (at most every ADMIT_PERIOD seconds) and
+ * adjust the number of processes allowed to run at once.
+ *
+ * Pressure is computed from the difference of PSI stall totals between
+ * samples, so it reacts within one period rather than the ten seconds of
+ * avg10. Without PSI (old kernels) only available memory is checked.
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ **/
+void scheduler_admit(Scheduler *s) {
+    Time now = timestamp();
+    if (s->admit_time && now - s->admit_time < ADMIT_PERIOD) {
+        return;
+    }
+
+    Time   memory_stall = 0, cpu_stall = 0, usage = 0;
+    size_t available    = 0;
+    procfs_pressure("memory", &memory_stall);
+    procfs_pressure("cpu", &cpu_stall);
+    procfs_available(&available);
+
+    /* Resident set and CPU use of running jobs */
+    for (Process *p = s->running.head; p; p = p->next) {
+        char   state;
+        Time   cpu_time;
+        size_t rss;
+
+        if (procfs_statm(p->pid, &rss)) {
+            p->rss     = rss;
+            s->job_rss = s->job_rss ? s->job_rss + ((ssize_t)rss - (ssize_t)s->job_rss) / 8 : rss;
+        }
+        if (procfs_stat(p->pid, &state, &cpu_time)) {
+            usage      += cpu_time - p->cpu_time;
+            p->cpu_time = cpu_time;
+        }
+    }
+
+    if (s->admit_time) {
+        double elapsed = now - s->admit_time;
+        scheduler_admit_update(s,
+            (memory_stall - s->memory_stall) / elapsed,
+            (cpu_stall - s->cpu_stall) / elapsed,
+            usage / elapsed, available);                            // ratios of nanoseconds
+    }
+
+    s->admit_time   = now;
+    s->memory_stall = memory_stall;
+    s->cpu_stall    = cpu_stall;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,124 @@
+/* scheduler_cfs.c: PQSH Completely Fair Scheduler */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/process.h"
+#include "../include/pqsh/timestamp.h"
+
+#include <assert.h>
+
+/**
+ * Order processes by virtual runtime (ties broken by insertion order).
+ **/
+static int cfs_compare(const RBNode *a, const RBNode *b) {
+    const Process *pa = container_of(a, Process, node);
+    const Process *pb = container_of(b, Process, node);
+
+    if (pa->vruntime < pb->vruntime) return -1;
+    if (pa->vruntime > pb->vruntime) return  1;
+    return 0;
+}
+
+/**
+ * Return virtual runtime of running process including its current slice.
+ * @param   p       Running process
+ * @param   now     Current timestamp
+ **/
+static Time cfs_vruntime(Process *p, Time now) {
+    return p->vruntime + (Time)((now - p->dispatch_time) / p->weight);
+}
+
+/**
+ * Pause running process, charge its slice, and place it in the tree.
+ * @param   s	    Scheduler structure
+ * @param   p       Running process
+ * @param   now     Current timestamp
+ **/
+static void cfs_preempt(Scheduler *s, Process *p, Time now) {
+    p->vruntime = cfs_vruntime(p, now);
+    scheduler_preempt(s, p);
+    rbtree_insert(&s->tree, &p->node, cfs_compare);
+}
+
+/**
+ * Start or resume the process with the lowest virtual runtime.
+ * @param   s	    Scheduler structure
+ **/
+static void cfs_dispatch(Scheduler *s) {
+    Process *p = container_of(rbtree_first(&s->tree), Process, node);
+    rbtree_remove(&s->tree, &p->node);
+    scheduler_dispatch(s, p);
+}
+
+/**
+ * Return running process with the highest virtual runtime.
+ * @param   s	    Scheduler structure
+ * @param   now     Current timestamp
+ **/
+static Process *cfs_victim(Scheduler *s, Time now) {
+    Process *victim = NULL;
+    for (Process *p = s->running.head; p; p = p->next) {
+        if (!victim || cfs_vruntime(p, now) > cfs_vruntime(victim, now)) {
+            victim = p;
+        }
+    }
+    return victim;
+}
+
+/**
+ * Schedule next process using completely fair policy:
+ *
+ *  1. New arrivals are placed in the tree with the current minimum virtual
+ *  runtime so they neither starve nor are starved by existing processes.
+ *
+ *  2. While the running process with the highest virtual runtime is ahead
+ *  of the leftmost waiting process by a time slice (rounded to the nearest
+ *  timer interrupt), swap them.
+ *
+ *  3. Idle cores take the leftmost waiting processes.
+ *
+ *  Virtual runtime advances by wall time on a core divided by weight, so a
+ *  process with twice the weight receives twice the share of a core.
+ *
+ * @param   s	    Scheduler structure
+ **/
+void scheduler_cfs(Scheduler *s) {
+    Time   now         = timestamp();
+    Time   granularity = s->timeout * NSEC_PER_USEC;
+    Process *p;
+
+    /* Arrivals */
+    while ((p = queue_pop(&s->waiting))) {
+        p->vruntime = max(p->vruntime, s->min_vruntime);
+        rbtree_insert(&s->tree, &p->node, cfs_compare);
+    }
+
+    /* Preemption */
+    while (s->tree.size && s->running.size >= s->cores) {
+        Process *victim = cfs_victim(s, now);
+        Process *first  = container_of(rbtree_first(&s->tree), Process, node);
+
+        if (cfs_vruntime(victim, now) - first->vruntime < granularity / 2) {
+            break;
+        }
+        cfs_preempt(s, victim, now);
+        cfs_dispatch(s);
+    }
+
+    /* Fill idle cores */
+    while (s->running.size < s->cores && s->tree.size) {
+        cfs_dispatch(s);
+    }
+
+    /* Track monotonic minimum virtual runtime */
+    if (s->tree.size || s->running.size) {
+        Time minimum = s->tree.size ?
+            container_of(rbtree_first(&s->tree), Process, node)->vruntime : cfs_vruntime(s->running.head, now);
+        for (p = s->running.head; p; p = p->next) {
+            minimum = min(minimum, cfs_vruntime(p, now));
+        }
+        s->min_vruntime = max(s->min_vruntime, minimum);
+    }
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,95 @@
+/* scheduler_edf.c: PQSH Earliest Deadline First Scheduler */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/process.h"
+
+#include <stdint.h>
+
+/**
+ * Return deadline of process (processes without one come last).
+ * @param   p       Process
+ **/
+static Time edf_deadline(const Process *p) {
+    return p->deadline ? p->deadline : INT64_MAX;
+}
+
+/**
+ * Order waiting processes by deadline (ties broken by insertion order).
+ **/
+static int edf_compare(const RBNode *a, const RBNode *b) {
+    Time da = edf_deadline(container_of(a, Process, node));
+    Time db = edf_deadline(container_of(b, Process, node));
+
+    if (da < db) return -1;
+    if (da > db) return  1;
+    return 0;
+}
+
+/**
+ * Start or resume the waiting process with the earliest deadline.
+ * @param   s	    Scheduler structure
+ **/
+static void edf_dispatch(Scheduler *s) {
+    Process *p = container_of(rbtree_first(&s->tree), Process, node);
+    rbtree_remove(&s->tree, &p->node);
+    scheduler_dispatch(s, p);
+}
+
+/**
+ * Return running process with the latest deadline.
+ * @param   s	    Scheduler structure
+ **/
+static Process *edf_victim(Scheduler *s) {
+    Process *victim = NULL;
+    for (Process *p = s->running.head; p; p = p->next) {
+        if (!victim || edf_deadline(p) > edf_deadline(victim)) {
+            victim = p;
+        }
+    }
+    return victim;
+}
+
+/**
+ * Schedule next process using earliest deadline first policy:
+ *
+ *  1. New arrivals are placed in the tree ordered by absolute deadline
+ *  (processes added without --deadline come last, in arrival order).
+ *
+ *  2. While a waiting process has an earlier deadline than the running
+ *  process with the latest deadline, swap them. Arrivals are scheduled
+ *  immediately, so an urgent job does not wait for the next timer
+ *  interrupt.
+ *
+ *  3. Idle cores take the waiting processes with the earliest deadlines.
+ *
+ * @param   s	    Scheduler structure
+ **/
+void scheduler_edf(Scheduler *s) {
+    Process *p;
+
+    /* Arrivals */
+    while ((p = queue_pop(&s->waiting))) {
+        rbtree_insert(&s->tree, &p->node, edf_compare);
+    }
+
+    /* Preemption */
+    while (s->tree.size && s->running.size >= s->cores) {
+        Process *victim = edf_victim(s);
+        Process *first  = container_of(rbtree_first(&s->tree), Process, node);
+
+        if (edf_deadline(first) >= edf_deadline(victim)) {
+            break;
+        }
+        scheduler_preempt(s, victim);
+        rbtree_insert(&s->tree, &victim->node, edf_compare);
+        edf_dispatch(s);
+    }
+
+    /* Fill idle cores */
+    while (s->running.size < s->cores && s->tree.size) {
+        edf_dispatch(s);
+    }
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
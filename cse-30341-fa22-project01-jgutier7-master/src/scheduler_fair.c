@@ -0,0 +1,257 @@
+/* scheduler_fair.c: PQSH Hierarchical Fair-Share Scheduler */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/process.h"
+#include "../include/pqsh/intern.h"
+#include "../include/pqsh/timestamp.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Return tenant with name, creating it (weight 1, fifo) on first use.
+ * @param   s	    Scheduler structure
+ * @param   name    Name of tenant.
+ * @return  Pointer to Tenant (NULL if it could not be created).
+ **/
+Tenant *scheduler_tenant(Scheduler *s, const char *name) {
+    for (size_t i = 0; i < s->ntenants; i++) {
+        if (streq(s->tenants[i]->name, name)) {
+            return s->tenants[i];
+        }
+    }
+
+    Tenant **grown = realloc(s->tenants, (s->ntenants + 1) * sizeof(Tenant *));
+    if (!grown) {
+        return NULL;
+    }
+    s->tenants = grown;
+
+    Tenant *t = calloc(1, sizeof(Tenant));
+    if (!t) {
+        return NULL;
+    }
+    t->name = intern_acquire(name);
+    if (!t->name) {
+        free(t);
+        return NULL;
+    }
+    t->weight = 1;
+    t->policy = FIFO_POLICY;
+    s->tenants[s->ntenants++] = t;
+    return t;
+}
+
+/**
+ * Configure tenant from NAME:WEIGHT[:POLICY] (POLICY is fifo or rdrn).
+ * @param   s	    Scheduler structure
+ * @param   spec    Tenant specification.
+ * @return  Whether or not the specification was valid.
+ **/
+bool scheduler_tenant_config(Scheduler *s, const char *spec) {
+    char   name[BUFSIZ];
+    char   policy[BUFSIZ] = "fifo";
+    double weight = 0;
+
+    if (sscanf(spec, "%[^:]:%lf:%s", name, &weight, policy) < 2 || weight <= 0) {
+        return false;
+    }
+    if (!streq(policy, "fifo") && !streq(policy, "rdrn")) {
+        return false;
+    }
+
+    Tenant *t = scheduler_tenant(s, name);
+    if (!t) {
+        return false;
+    }
+    t->weight = weight;
+    t->policy = streq(policy, "rdrn") ? RDRN_POLICY : FIFO_POLICY;
+    return true;
+}
+
+/**
+ * Return number of jobs tenant wants to run.
+ **/
+static size_t fair_demand(const Tenant *t) {
+    return t->running + t->waiting.size;
+}
+
+/**
+ * Divide cores among tenants in proportion to weight, never giving a tenant
+ * more than it can use (water-filling), and set each tenant's whole number
+ * of cores. Cores left over from rounding go to the tenants furthest behind
+ * in virtual runtime, so fractional shares are met over time.
+ * @param   s	    Scheduler structure
+ * @param   targets Number of cores per tenant (output).
+ **/
+static void fair_divide(Scheduler *s, size_t *targets) {
+    double shares[s->ntenants];
+    bool   satisfied[s->ntenants];
+    double cores = s->cores;
+
+    for (size_t i = 0; i < s->ntenants; i++) {
+        shares[i]    = 0;
+        satisfied[i] = !fair_demand(s->tenants[i]);
+    }
+
+    /* Tenants wanting less than their share are satisfied first */
+    for (bool changed = true; changed; ) {
+        double weight = 0;
+        changed = false;
+        for (size_t i = 0; i < s->ntenants; i++) {
+            weight += satisfied[i] ? 0 : s->tenants[i]->weight;
+        }
+        for (size_t i = 0; weight > 0 && i < s->ntenants; i++) {
+            Tenant *t = s->tenants[i];
+            if (!satisfied[i] && fair_demand(t) <= cores * t->weight / weight) {
+                shares[i]    = fair_demand(t);
+                satisfied[i] = true;
+                changed      = true;
+                cores       -= shares[i];
+            }
+        }
+        for (size_t i = 0; !changed && i < s->ntenants; i++) {
+            if (!satisfied[i]) {
+                shares[i] = cores * s->tenants[i]->weight / weight;
+            }
+        }
+    }
+
+    /* Whole cores, then leftovers by virtual runtime */
+    size_t leftover = s->cores;
+    for (size_t i = 0; i < s->ntenants; i++) {
+        targets[i]   = (size_t)(shares[i] + 1e-9);
+        leftover    -= min(leftover, targets[i]);
+        satisfied[i] = targets[i] >= fair_demand(s->tenants[i]);
+    }
+    while (leftover--) {
+        size_t behind = s->ntenants;
+        for (size_t i = 0; i < s->ntenants; i++) {
+            if (!satisfied[i] && (behind == s->ntenants || s->tenants[i]->vruntime < s->tenants[behind]->vruntime)) {
+                behind = i;
+            }
+        }
+        if (behind == s->ntenants) {
+            break;
+        }
+        targets[behind]++;
+        satisfied[behind] = true;
+    }
+}
+
+/**
+ * Pause running job of tenant and return it to the tenant's queue.
+ *
+ * Round robin tenants pause their longest running job, which goes to the
+ * back of the queue. Fifo tenants pause their most recently started job,
+ * which goes back to the front.
+ *
+ * @param   s	    Scheduler structure
+ * @param   t       Tenant with a running job.
+ **/
+static void fair_preempt(Scheduler *s, Tenant *t) {
+    Process *p = t->policy == RDRN_POLICY ? s->running.head : s->running.tail;
+    while (p->tenant != t) {
+        p = t->policy == RDRN_POLICY ? p->next : p->prev;
+    }
+
+    scheduler_preempt(s, p);
+    if (t->policy == RDRN_POLICY) {
+        queue_push(&t->waiting, p);
+    } else {
+        queue_insert(&t->waiting, p, t->waiting.head);
+    }
+    t->running--;
+}
+
+/**
+ * Schedule next process using hierarchical fair-share policy:
+ *
+ *  1. New arrivals join the queue of their tenant (TENANT_DEFAULT if added
+ *  without --tenant).
+ *
+ *  2. Tenants are charged for the cores their jobs held since the last
+ *  schedule, divided by their weight. A tenant that was idle starts at the
+ *  minimum virtual runtime of active tenants, so it cannot bank credit.
+ *
+ *  3. Cores are divided among tenants in proportion to weight, capped by
+ *  how many jobs each tenant has (see fair_divide).
+ *
+ *  4. Tenants over their share give cores back; round robin tenants at
+ *  their share with jobs waiting rotate one job.
+ *
+ *  5. Tenants under their share start or resume jobs from their queue.
+ *
+ *  One tenant flooding the shell with jobs thus only ever holds its share
+ *  of the cores while other tenants have work.
+ *
+ * @param   s	    Scheduler structure
+ **/
+void scheduler_fair(Scheduler *s) {
+    Time     now     = timestamp();
+    Time     elapsed = s->tenant_time ? now - s->tenant_time : 0;
+    Process *p;
+
+    /* Arrivals */
+    while ((p = queue_pop(&s->waiting))) {
+        if (!p->tenant && !(p->tenant = scheduler_tenant(s, TENANT_DEFAULT))) {
+            error("Unable to create tenant %s", TENANT_DEFAULT);
+            queue_push(&s->waiting, p);
+            return;
+        }
+        Tenant *t = p->tenant;
+        if (!fair_demand(t)) {
+            t->vruntime = max(t->vruntime, s->min_tenant_vruntime);
+        }
+        queue_push(&t->waiting, p);
+    }
+    if (!s->ntenants) {
+        return;
+    }
+
+    /* Charge tenants for the cores they held */
+    Time minimum = INT64_MAX;
+    for (size_t i = 0; i < s->ntenants; i++) {
+        Tenant *t = s->tenants[i];
+        t->vruntime += (Time)(t->running * elapsed / t->weight);
+        t->running   = 0;
+    }
+    for (p = s->running.head; p; p = p->next) {
+        p->tenant->running++;
+    }
+    for (size_t i = 0; i < s->ntenants; i++) {
+        if (fair_demand(s->tenants[i])) {
+            minimum = min(minimum, s->tenants[i]->vruntime);
+        }
+    }
+    if (minimum != INT64_MAX) {
+        s->min_tenant_vruntime = max(s->min_tenant_vruntime, minimum);
+    }
+    s->tenant_time = now;
+
+    /* Divide cores */
+    size_t targets[s->ntenants];
+    fair_divide(s, targets);
+
+    /* Tenants over their share give cores back (round robin tenants rotate) */
+    for (size_t i = 0; i < s->ntenants; i++) {
+        Tenant *t = s->tenants[i];
+        while (t->running > targets[i]) {
+            fair_preempt(s, t);
+        }
+        if (t->policy == RDRN_POLICY && t->running && t->running == targets[i] && t->waiting.size) {
+            fair_preempt(s, t);
+        }
+    }
+
+    /* Tenants under their share start jobs */
+    for (size_t i = 0; i < s->ntenants; i++) {
+        Tenant *t = s->tenants[i];
+        while (t->running < targets[i] && s->running.size < s->cores && (p = queue_pop(&t->waiting))) {
+            t->running += scheduler_dispatch(s, p);
+        }
+    }
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
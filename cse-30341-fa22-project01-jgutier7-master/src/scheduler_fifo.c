@@ -14,15 +14,19 @@
  *  there are waiting processes, then we should move a process from the
  *  waiting queue to the running queue.
  *
+ *  With admission control the number of CPUS is replaced by a limit that
+ *  follows memory and CPU pressure.
+ *
  * @param   s	    Scheduler structure
  */
 void scheduler_fifo(Scheduler *s) {
-    /* TODO: Implement FIFO Policy */
-    while((s->running).size < s->cores && (s->waiting).size != 0) { 				// while s.running.size() < NCPUS and not s.waiting.empty():
+    if (s->memory_limit > 0 && s->launch != LAUNCH_SIMULATE) {
+        scheduler_admit(s);
+    }
+
+    while((s->running).size < s->limit && (s->waiting).size != 0) { 				// while s.running.size() < NCPUS and not s.waiting.empty():
 		Process *p = queue_pop(&(s->waiting)); 										// process = s.waiting.pop()
-		process_start(p); 															// StartProcess(process)
-		queue_push(&(s->running),p);												// s.running.push(process)
-		p->start_time = timestamp();
+		scheduler_dispatch(s, p);													// StartProcess(process), s.running.push(process)
 	}
 }
 
@@ -0,0 +1,215 @@
+/* scheduler_journal.c: PQSH Scheduler Crash Recovery */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Journal records (one per line, fields separated by tabs):
+ *
+ *  A SEQUENCE ARRIVAL ADD      Job was added (ADD is the add command without "add")
+ *  F SEQUENCE STATUS START END RUN
+ *                              Job finished with wait STATUS
+ *
+ * Jobs that were running when the shell died have no F record, so they are
+ * run again after recovery. A clean shutdown terminates and reaps launched
+ * jobs first (scheduler_shutdown), so only jobs that never started remain.
+ */
+
+/**
+ * Record job submission.
+ *
+ * Options are rebuilt from the process rather than copied from the input,
+ * so compaction can write the same record.
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to new Process.
+ **/
+void scheduler_journal_add(Scheduler *s, Process *p) {
+    if (s->journal.replaying) {
+        return;                                                     // sequence comes from the record
+    }
+    p->sequence = ++s->journal.sequence;
+    if (!s->journal.path) {
+        return;
+    }
+
+    if (!p->dag && p->weight == 1 && p->tickets == TICKETS_DEFAULT && !p->deadline && !p->tenant) {                                // common case: no options
+        journal_append(&s->journal, "A\t%lu\t%.6lf\t-- %s\n", p->sequence, timestamp_wall(p->arrival_time), p->command);
+        return;
+    }
+
+    char   options[BUFSIZ] = "";
+    size_t length          = 0;
+    if (p->weight != 1) {
+        length += snprintf(options + length, BUFSIZ - length, "-w %lf ", p->weight);
+    }
+    if (p->tickets != TICKETS_DEFAULT) {
+        length += snprintf(options + length, BUFSIZ - length, "-t %lu ", p->tickets);
+    }
+    if (p->tenant) {
+        length += snprintf(options + length, BUFSIZ - length, "--tenant %s ", p->tenant->name);
+    }
+    if (p->deadline) {
+        length += snprintf(options + length, BUFSIZ - length, "--deadline %.9lf ", time_to_seconds(p->deadline - p->arrival_time));
+    }
+    if (p->dag && p->dag->id) {
+        length += snprintf(options + length, BUFSIZ - length, "--id %s ", p->dag->id);
+    }
+    for (size_t i = 0; p->dag && i < p->dag->nafter && length < BUFSIZ; i++) {
+        length += snprintf(options + length, BUFSIZ - length, "%s%s%s",
+            i ? "," : "--after ", p->dag->after[i]->id, i + 1 < p->dag->nafter ? "" : " ");
+    }
+    if (length >= BUFSIZ) {
+        error("Unable to journal options of %s", p->command);
+        return;
+    }
+    journal_append(&s->journal, "A\t%lu\t%.6lf\t%s-- %s\n", p->sequence, timestamp_wall(p->arrival_time), options, p->command);
+}
+
+/**
+ * Record job exit (or cancellation).
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to finished Process.
+ **/
+void scheduler_journal_finish(Scheduler *s, Process *p) {
+    if (p->sequence) {
+        journal_append(&s->journal, "F\t%lu\t%d\t%.6lf\t%.6lf\t%.6lf\n",
+            p->sequence, p->status, timestamp_wall(p->start_time), timestamp_wall(p->end_time), time_to_seconds(p->run_time));
+    }
+}
+
+/**
+ * Rewrite journal with one record per job in the current state.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   jobs    Processes indexed by sequence number (NULL == gap).
+ * @param   count   Number of entries in jobs.
+ * @return  Whether or not the journal was replaced.
+ **/
+static bool scheduler_compact(Scheduler *s, Process **jobs, size_t count) {
+    char temporary[BUFSIZ];
+    snprintf(temporary, BUFSIZ, "%s.tmp", s->journal_path);
+
+    if (!journal_open(&s->journal, temporary, true)) {
+        return false;
+    }
+
+    /* Jobs are renumbered in sequence order, which keeps dependencies ahead of their dependents */
+    s->journal.sequence = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i]) {
+            scheduler_journal_add(s, jobs[i]);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i] && jobs[i]->queue == &s->finished) {
+            scheduler_journal_finish(s, jobs[i]);
+        }
+    }
+
+    bool committed = journal_commit(&s->journal);
+    journal_close(&s->journal);
+
+    if (!committed || rename(temporary, s->journal_path) < 0) {
+        error("Unable to replace journal %s: %s", s->journal_path, strerror(errno));
+        unlink(temporary);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Rebuild waiting and finished jobs from the journal, then compact it and
+ * reopen it for appending.
+ *
+ * A torn record at the end (from a crash mid-write) and anything after it
+ * are ignored. Must be called before anything is scheduled.
+ *
+ * @param   s	    Pointer to Scheduler structure (journal_path must be set).
+ * @return  Whether or not the journal is ready for appending.
+ **/
+bool scheduler_recover(Scheduler *s) {
+    Process **jobs     = NULL;
+    size_t    count    = 0;
+    size_t    records  = 0;
+    char     *line     = NULL;
+    size_t    capacity = 0;
+    ssize_t   length;
+
+    FILE *fs = fopen(s->journal_path, "r");
+    if (!fs && errno != ENOENT) {
+        error("Unable to open journal %s: %s", s->journal_path, strerror(errno));
+        return false;
+    }
+
+    s->journal.replaying = true;
+    while (fs && (length = getline(&line, &capacity, fs)) > 0) {
+        size_t sequence;
+        double arrival, start, end, run;
+        int    status, offset = 0;
+
+        if (line[length - 1] != '\n') {                             // torn write
+            break;
+        }
+        line[length - 1] = 0;
+
+        if (sscanf(line, "A\t%lu\t%lf\t%n", &sequence, &arrival, &offset) == 2 && offset) {
+            Process *p = scheduler_add(s, NULL, line + offset);
+            if (!p) {
+                continue;
+            }
+            Time arrival_time = timestamp_from_wall(arrival);
+            if (p->deadline) {
+                p->deadline += arrival_time - p->arrival_time;       // relative to original arrival
+            }
+            p->arrival_time = arrival_time;
+            p->sequence     = sequence;
+            if (sequence >= count) {
+                size_t    grown_count = max(sequence + 1, count * 2);
+                Process **grown       = realloc(jobs, grown_count * sizeof(Process *));
+                if (!grown) {
+                    break;
+                }
+                memset(grown + count, 0, (grown_count - count) * sizeof(Process *));
+                jobs  = grown;
+                count = grown_count;
+            }
+            jobs[sequence] = p;
+        } else if (sscanf(line, "F\t%lu\t%d\t%lf\t%lf\t%lf", &sequence, &status, &start, &end, &run) == 5) {
+            Process *p = sequence < count ? jobs[sequence] : NULL;
+            if (!p || p->queue == &s->finished) {
+                continue;                                           // unknown or already cancelled
+            }
+            queue_unlink(p);
+            p->status     = status;
+            p->start_time = timestamp_from_wall(start);
+            p->end_time   = timestamp_from_wall(end);
+            p->run_time   = time_from_seconds(run);
+            scheduler_finish(s, p);
+        } else {
+            error("Ignoring invalid journal record: %s", line);
+            continue;
+        }
+        records++;
+    }
+    s->journal.replaying = false;
+
+    if (fs) {
+        fclose(fs);
+    }
+    free(line);
+
+    if (records) {
+        info("Recovered %lu waiting and %lu finished jobs from %s",
+            scheduler_waiting(s), s->finished.size, s->journal_path);
+    }
+
+    bool compacted = scheduler_compact(s, jobs, count);
+    free(jobs);
+    return compacted && journal_open(&s->journal, s->journal_path, false);
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,98 @@
+/* scheduler_lottery.c: PQSH Lottery Scheduler */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/process.h"
+
+#include <assert.h>
+
+/**
+ * Return next pseudo-random number (xorshift64*).
+ * @param   s	    Scheduler structure
+ **/
+static uint64_t lottery_random(Scheduler *s) {
+    s->seed ^= s->seed >> 12;
+    s->seed ^= s->seed << 25;
+    s->seed ^= s->seed >> 27;
+    return s->seed * UINT64_C(2685821657736338717);
+}
+
+/**
+ * Draw winning ticket and take its holder out of the lottery.
+ * @param   s	    Scheduler structure
+ * @return  Pointer to winning Process.
+ **/
+static Process *lottery_winner(Scheduler *s) {
+    Process *p = lottery_draw(&s->lottery, lottery_random(s) % s->lottery.total);
+    assert(p);
+    lottery_remove(&s->lottery, p);
+    return p;
+}
+
+/**
+ * Schedule next process using lottery policy:
+ *
+ *  1. New arrivals receive their tickets in the lottery.
+ *
+ *  2. If every core is busy and processes are waiting, running processes
+ *  re-enter the lottery and a winner is drawn for every core. Running
+ *  processes that lose are paused and keep their tickets; winners that were
+ *  waiting are started or resumed.
+ *
+ *  3. Otherwise a winner is drawn for every idle core.
+ *
+ *  Each draw picks a ticket uniformly, so over many time slices a process
+ *  holds a core in proportion to its share of the tickets. Ticket counts
+ *  live in a Fenwick tree, so a draw costs O(log n) in waiting processes.
+ *
+ * @param   s	    Scheduler structure
+ **/
+void scheduler_lottery(Scheduler *s) {
+    Queue    winners = {0};
+    Process *p;
+
+    /* Arrivals */
+    while ((p = queue_pop(&s->waiting))) {
+        if (!lottery_insert(&s->lottery, p)) {
+            error("Unable to add process to lottery: %s", p->command);
+            queue_push(&s->waiting, p);
+            break;
+        }
+    }
+    if (!s->lottery.size) {
+        return;
+    }
+
+    /* Running processes re-enter the draw once every core is busy */
+    size_t draws = s->cores - min(s->running.size, s->cores);
+    if (!draws) {
+        for (p = s->running.head; p; p = p->next) {
+            if (!lottery_insert(&s->lottery, p)) {
+                break;
+            }
+            draws++;
+        }
+    }
+
+    /* Draw winners (running winners keep their core) */
+    while (draws-- && s->lottery.size) {
+        p = lottery_winner(s);
+        if (p->queue != &s->running) {
+            queue_push(&winners, p);
+        }
+    }
+
+    /* Losers give up their cores and keep their tickets */
+    for (Process *next, *q = s->running.head; q; q = next) {
+        next = q->next;
+        if (lottery_contains(&s->lottery, q)) {
+            scheduler_preempt(s, q);
+        }
+    }
+
+    while ((p = queue_pop(&winners))) {
+        scheduler_dispatch(s, p);
+    }
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,164 @@
+/* scheduler_mlfq.c: PQSH Multi-Level Feedback Queue Scheduler */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/process.h"
+#include "../include/pqsh/timestamp.h"
+
+#include <assert.h>
+
+/**
+ * Return time slice for priority level (doubles with each level).
+ * @param   s	    Scheduler structure
+ * @param   level   Priority level
+ * @return  Time slice.
+ **/
+static Time mlfq_quantum(Scheduler *s, size_t level) {
+    return (s->timeout << level) * NSEC_PER_USEC;
+}
+
+/**
+ * Return whether or not running process has used its entire time slice
+ * (rounded to the nearest timer interrupt).
+ * @param   s	    Scheduler structure
+ * @param   p       Running process
+ * @param   now     Current timestamp
+ **/
+static bool mlfq_expired(Scheduler *s, Process *p, Time now) {
+    Time slack = s->timeout * NSEC_PER_USEC / 2;
+    return now - p->dispatch_time + slack >= mlfq_quantum(s, p->level);
+}
+
+/**
+ * Pause running process and place it in the waiting queue for its level.
+ * @param   s	    Scheduler structure
+ * @param   p       Running process
+ **/
+static void mlfq_preempt(Scheduler *s, Process *p) {
+    scheduler_preempt(s, p);
+    queue_push(&s->level[p->level], p);
+}
+
+/**
+ * Return lowest priority running process (NULL if none is below level).
+ * @param   s	    Scheduler structure
+ * @param   level   Priority level to compare against
+ **/
+static Process *mlfq_victim(Scheduler *s, size_t level) {
+    Process *victim = NULL;
+    for (Process *p = s->running.head; p; p = p->next) {
+        if (p->level > level && (!victim || p->level > victim->level)) {
+            victim = p;
+        }
+    }
+    return victim;
+}
+
+/**
+ * Return number of waiting processes at or above priority level.
+ * @param   s	    Scheduler structure
+ * @param   level   Lowest priority level to count
+ **/
+static size_t mlfq_waiting(Scheduler *s, size_t level) {
+    size_t waiting = 0;
+    for (size_t l = 0; l <= level; l++) {
+        waiting += s->level[l].size;
+    }
+    return waiting;
+}
+
+/**
+ * Return highest priority level with waiting processes (levels if none).
+ * @param   s	    Scheduler structure
+ **/
+static size_t mlfq_highest(Scheduler *s) {
+    size_t level = 0;
+    while (level < s->levels && s->level[level].size == 0) {
+        level++;
+    }
+    return level;
+}
+
+/**
+ * Schedule next process using multi-level feedback queue policy:
+ *
+ *  1. Every boost period, move all processes back to the highest level
+ *  (running processes start a new slice there).
+ *
+ *  2. New arrivals enter the highest priority level.
+ *
+ *  3. A running process that used its entire slice is demoted one level;
+ *  each lower level has twice the slice of the one above it. It is only
+ *  paused if a waiting process at its new level or above would take its
+ *  core (rather than an idle one); otherwise it starts a new slice.
+ *
+ *  4. Running processes are preempted by waiting processes at a higher
+ *  priority level.
+ *
+ *  5. Idle cores take the front of the highest non-empty level.
+ *
+ * @param   s	    Scheduler structure
+ **/
+void scheduler_mlfq(Scheduler *s) {
+    Time now = timestamp();
+
+    /* Priority boost */
+    if (s->boost && now - s->last_boost >= s->boost * NSEC_PER_USEC) {
+        for (size_t level = 1; level < s->levels; level++) {
+            Process *p;
+            while ((p = queue_pop(&s->level[level]))) {
+                p->level = 0;
+                queue_push(&s->level[0], p);
+            }
+        }
+        for (Process *p = s->running.head; p; p = p->next) {
+            p->level         = 0;
+            p->run_time     += now - p->dispatch_time;
+            p->dispatch_time = now;
+        }
+        s->last_boost = now;
+    }
+
+    /* Arrivals */
+    Process *p;
+    while ((p = queue_pop(&s->waiting))) {
+        p->level = 0;
+        queue_push(&s->level[0], p);
+    }
+
+    /* Demotion (paused processes only rejoin their levels afterwards, so
+     * each waiting process takes at most one core) */
+    Queue demoted = {0};
+    for (Process *next, *p = s->running.head; p; p = next) {
+        next = p->next;
+        if (mlfq_expired(s, p, now)) {
+            p->level = min(p->level + 1, s->levels - 1);
+            if (mlfq_waiting(s, p->level) > s->cores - s->running.size) {
+                scheduler_preempt(s, p);
+                queue_push(&demoted, p);
+            } else {
+                p->run_time     += now - p->dispatch_time;  /* Nothing would take its core: start a new slice */
+                p->dispatch_time = now;
+            }
+        }
+    }
+    while ((p = queue_pop(&demoted))) {
+        queue_push(&s->level[p->level], p);
+    }
+
+    /* Preemption by higher priority */
+    size_t highest;
+    Process *victim;
+    while ((highest = mlfq_highest(s)) < s->levels && s->running.size >= s->cores &&
+           (victim = mlfq_victim(s, highest))) {
+        mlfq_preempt(s, victim);
+        scheduler_dispatch(s, queue_pop(&s->level[highest]));
+    }
+
+    /* Fill idle cores */
+    while (s->running.size < s->cores && (highest = mlfq_highest(s)) < s->levels) {
+        scheduler_dispatch(s, queue_pop(&s->level[highest]));
+    }
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
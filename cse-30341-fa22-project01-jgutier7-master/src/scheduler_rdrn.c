@@ -7,6 +7,99 @@
 
 #include <assert.h>
 
+/**
+ * Return number of processes bound to core (waiting or running).
+ **/
+static size_t rdrn_load(Scheduler *s, size_t core) {
+    return s->runqueues[core].size + (s->slots[core] != NULL);
+}
+
+/**
+ * Move sleeping process from its core to the back of a waiting queue.
+ * @param   s	    Scheduler structure
+ * @param   p       Running process.
+ * @param   q       Queue to wait in.
+ * @return  Whether or not the process was sleeping.
+ **/
+static bool rdrn_swap(Scheduler *s, Process *p, Queue *q) {
+    if (!scheduler_sleeping(s, p)) {
+        return false;
+    }
+    scheduler_preempt(s, p);
+    queue_push(q, p);
+    s->sleep_swaps++;
+    return true;
+}
+
+/**
+ * Schedule next process using round robin with per-core run queues:
+ *
+ *  1. Move arrivals to the run queue of the least loaded core.
+ *
+ *  2. If every core is busy, each core with others waiting in its run
+ *  queue moves its running process to the back of that run queue.
+ *
+ *  3. Each idle core takes the front of its own run queue, or steals the
+ *  front of the busiest run queue if its own is empty.
+ *
+ *  Processes thus resume on the core (and pinned CPU) they last ran on
+ *  unless another core runs out of work.
+ *
+ * @param   s	    Scheduler structure
+ **/
+static void scheduler_rdrn_affinity(Scheduler *s) {
+    Process *p;
+
+    /* Arrivals */
+    while ((p = queue_pop(&s->waiting))) {
+        size_t target = 0;
+        for (size_t core = 1; core < s->cores; core++) {
+            if (rdrn_load(s, core) < rdrn_load(s, target)) {
+                target = core;
+            }
+        }
+        p->core = target;
+        queue_push(&s->runqueues[target], p);
+    }
+
+    /* Sleeping processes give up their core to their run queue */
+    for (size_t core = 0; s->swap_sleeping && core < s->cores; core++) {
+        if (s->slots[core] && s->runqueues[core].size) {
+            rdrn_swap(s, s->slots[core], &s->runqueues[core]);
+        }
+    }
+
+    /* Preemption (only once every core is busy, as with a single queue) */
+    for (size_t core = 0; s->running.size >= s->cores && core < s->cores; core++) {
+        if (s->slots[core] && s->runqueues[core].size) {
+            p = s->slots[core];
+            scheduler_preempt(s, p);
+            queue_push(&s->runqueues[core], p);
+        }
+    }
+
+    /* Idle cores */
+    for (size_t core = 0; core < s->cores; core++) {
+        if (s->slots[core]) {
+            continue;
+        }
+
+        size_t source = core;
+        if (!s->runqueues[core].size) {
+            for (size_t other = 0; other < s->cores; other++) {
+                if (s->runqueues[other].size > s->runqueues[source].size) {
+                    source = other;
+                }
+            }
+        }
+
+        if ((p = queue_pop(&s->runqueues[source]))) {
+            p->core = core;
+            scheduler_dispatch(s, p);
+        }
+    }
+}
+
 /**
  * Schedule next process using round robin policy:
  *
@@ -18,26 +111,39 @@
  *  3. Move one process from front of waiting queue and place in back of
  *  running queue.
  *
+ *  When swapping sleeping processes, running processes blocked in S or D
+ *  state first move to the back of the waiting queue (at most one per
+ *  waiting process), so their cores go to processes that can use them.
+ *  Stopped processes cannot be observed waking up, so swapped processes
+ *  simply take their turn again.
+ *
  * @param   s	    Scheduler structure
  **/
 void scheduler_rdrn(Scheduler *s) {
     /* TODO: Implement Round Robin Policy */
-	if((s->running).size == s->cores) {															// if s.running.size() == NCPUS:
-		Process *p = queue_pop(&(s->waiting)); 													// 	process = s.running.pop()
-		process_pause(p);																		// 	PauseProcess(process) ... Preemptive by pausing process
+	if (s->affinity) {
+		scheduler_rdrn_affinity(s);
+		return;
+	}
+
+	if (s->swap_sleeping) {
+		size_t candidates = s->waiting.size;
+		for (Process *next, *p = s->running.head; p && candidates; p = next) {
+			next = p->next;
+			candidates -= rdrn_swap(s, p, &s->waiting);
+		}
+	}
+
+	if((s->running).size == s->cores && (s->waiting).size != 0) {															// if s.running.size() == NCPUS:
+		Process *p = s->running.head;														// 	process = s.running.pop()
+		scheduler_preempt(s, p);														// 	PauseProcess(process) ... Preemptive by pausing process
 		queue_push(&(s->waiting),p);															// 	s.waiting.push(process)
 	}
 	
 	/* Move processes from waiting queue to running queue */
 	while((s->running).size < s->cores && (s->waiting).size != 0) { 							// while s.running.size() < NCPUS and not s.waiting.empty():
 		Process *p = queue_pop(&(s->waiting));													// 	process = s.waiting.pop()
-		if(p->pid == 0) {																		// 	if process.pid == 0:
-			process_start(p);																	// 		Start new process
-		} else {																				// 	else:
-			process_resume(p);																	// 		Resume old process
-		}
-		queue_push(&(s->running),p);															// 	s.running.push(process)
-		p->start_time = timestamp();
+		scheduler_dispatch(s, p);														// 	Start new or resume old process, s.running.push(process)
 	}
 	
 }
@@ -0,0 +1,85 @@
+/* scheduler_slice.c: PQSH Adaptive Time Slice */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+
+/**
+ * Record cost of a timer interrupt that preempted at least one process.
+ *
+ * The cost spans from the moment the timer expired to the moment the next
+ * processes were resumed, so it includes wakeup latency of the shell as well
+ * as the SIGSTOP/SIGCONT round trip.
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   cost    Time between timer expiration and end of rescheduling.
+ **/
+void scheduler_slice_cost(Scheduler *s, Time cost) {
+    cost = max(cost, (Time)0);
+    if (s->switch_cost == 0) {
+        s->switch_cost = cost;
+    } else {
+        s->switch_cost += (cost - s->switch_cost) / 8;              // EWMA: last ~8 interrupts
+    }
+}
+
+/**
+ * Record total CPU time of a finished process.
+ *
+ * Older bursts are halved away every SLICE_WINDOW samples so the slice
+ * follows the current workload rather than everything since startup. The
+ * percentile is only refreshed every SLICE_SAMPLES bursts, which keeps
+ * scheduler_slice constant time.
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   burst   CPU time the process used.
+ **/
+void scheduler_slice_burst(Scheduler *s, Time burst) {
+    histogram_record(&s->bursts, burst);
+    if (s->bursts.count >= SLICE_WINDOW) {
+        histogram_decay(&s->bursts);
+    }
+    if (s->bursts.count >= SLICE_SAMPLES && s->bursts.count % SLICE_SAMPLES == 0) {
+        s->burst = histogram_percentile(&s->bursts, SLICE_PERCENTILE);
+    }
+}
+
+/**
+ * Recompute adaptive time slice:
+ *
+ *  1. Long enough that a preemption costs at most the target fraction of the
+ *  slice (cost / (slice + cost) <= overhead).
+ *
+ *  2. Otherwise as short as possible for response time, but long enough for
+ *  SLICE_PERCENTILE percent of recent jobs to finish without preemption.
+ *
+ *  3. Never longer than timeout (unless required by 1), nor shorter than
+ *  SLICE_MIN.
+ *
+ * The slice only changes when it moves by more than an eighth, so the timer
+ * is not re-armed on every interrupt.
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ * @return  Time slice (microseconds).
+ **/
+time_t scheduler_slice(Scheduler *s) {
+    if (s->overhead <= 0) {
+        return s->slice = s->timeout;
+    }
+
+    Time needed = (Time)(s->switch_cost * (1 - s->overhead) / s->overhead);
+    Time want   = s->timeout * NSEC_PER_USEC;
+    if (s->burst > 0) {
+        want = min(want, s->burst);
+    }
+
+    time_t slice = (time_t)(max(want, needed) / NSEC_PER_USEC);
+    slice = max(slice, (time_t)SLICE_MIN);
+
+    time_t delta = slice > s->slice ? slice - s->slice : s->slice - slice;
+    if (!s->slice || delta > s->slice / 8) {
+        s->slice = slice;
+    }
+    return s->slice;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,123 @@
+/* scheduler_srtf.c: PQSH Shortest Remaining Time First Scheduler */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/process.h"
+#include "../include/pqsh/timestamp.h"
+
+#include <assert.h>
+
+/**
+ * Return predicted remaining run time of process (never negative).
+ * @param   p       Process
+ * @param   now     Current timestamp (0 if process is waiting)
+ **/
+static Time srtf_remaining(const Process *p, Time now) {
+    Time elapsed = now ? now - p->dispatch_time : 0;
+    return max(p->estimate - p->run_time - elapsed, (Time)0);
+}
+
+/**
+ * Re-estimate running process that has overrun its prediction: assume it
+ * needs as long again as it has already run (doubling the estimate on each
+ * overrun), so the job with the worst estimate does not become the most
+ * urgent one.
+ * @param   p       Running process
+ * @param   now     Current timestamp
+ **/
+static void srtf_reestimate(Process *p, Time now) {
+    Time used = p->run_time + now - p->dispatch_time;
+    if (used >= p->estimate) {
+        p->estimate = 2 * used;
+    }
+}
+
+/**
+ * Order waiting processes by predicted remaining run time.
+ **/
+static int srtf_compare(const RBNode *a, const RBNode *b) {
+    Time ra = srtf_remaining(container_of(a, Process, node), 0);
+    Time rb = srtf_remaining(container_of(b, Process, node), 0);
+
+    if (ra < rb) return -1;
+    if (ra > rb) return  1;
+    return 0;
+}
+
+/**
+ * Start or resume the waiting process with the shortest remaining time.
+ * @param   s	    Scheduler structure
+ **/
+static void srtf_dispatch(Scheduler *s) {
+    Process *p = container_of(rbtree_first(&s->tree), Process, node);
+    rbtree_remove(&s->tree, &p->node);
+    scheduler_dispatch(s, p);
+}
+
+/**
+ * Return running process with the longest remaining time.
+ * @param   s	    Scheduler structure
+ * @param   now     Current timestamp
+ **/
+static Process *srtf_victim(Scheduler *s, Time now) {
+    Process *victim = NULL;
+    for (Process *p = s->running.head; p; p = p->next) {
+        if (!victim || srtf_remaining(p, now) > srtf_remaining(victim, now)) {
+            victim = p;
+        }
+    }
+    return victim;
+}
+
+/**
+ * Schedule next process using shortest remaining time first policy:
+ *
+ *  1. New arrivals are given a predicted run time from the exponentially
+ *  weighted history of previous runs of the same command.
+ *
+ *  2. Running processes that overran their prediction are re-estimated.
+ *
+ *  3. While a waiting process is predicted to finish sooner than the running
+ *  process with the longest remaining time (by more than half a time slice,
+ *  to avoid thrashing on near ties), swap them.
+ *
+ *  4. Idle cores take the waiting processes with the shortest remaining time.
+ *
+ * @param   s	    Scheduler structure
+ **/
+void scheduler_srtf(Scheduler *s) {
+    Time   now        = timestamp();
+    Time   hysteresis = s->timeout * NSEC_PER_USEC / 2;
+    Process *p;
+
+    /* Arrivals */
+    while ((p = queue_pop(&s->waiting))) {
+        p->estimate = time_from_seconds(history_estimate(&s->history, p->command));
+        rbtree_insert(&s->tree, &p->node, srtf_compare);
+    }
+
+    /* Overruns */
+    for (p = s->running.head; p; p = p->next) {
+        srtf_reestimate(p, now);
+    }
+
+    /* Preemption */
+    while (s->tree.size && s->running.size >= s->cores) {
+        Process *victim = srtf_victim(s, now);
+        Process *first  = container_of(rbtree_first(&s->tree), Process, node);
+
+        if (srtf_remaining(first, 0) + hysteresis >= srtf_remaining(victim, now)) {
+            break;
+        }
+        scheduler_preempt(s, victim);
+        rbtree_insert(&s->tree, &victim->node, srtf_compare);
+        srtf_dispatch(s);
+    }
+
+    /* Fill idle cores */
+    while (s->running.size < s->cores && s->tree.size) {
+        srtf_dispatch(s);
+    }
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,305 @@
+/* scheduler_stats.c: PQSH Scheduler Metrics */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/wait.h>
+
+/* Constants */
+
+static const double PERCENTILES[] = { 50, 90, 99 };
+
+/**
+ * Return shell-style exit code for process (128 + signal if killed).
+ * @param   p       Pointer to finished Process.
+ **/
+static int stats_exit_code(const Process *p) {
+    return WIFSIGNALED(p->status) ? 128 + WTERMSIG(p->status) : WEXITSTATUS(p->status);
+}
+
+/**
+ * Return CPU time process used while holding a core.
+ *
+ * The rest of its run time it held a core while blocked (off CPU).
+ *
+ * @param   p       Pointer to finished Process.
+ **/
+static Time stats_on_cpu(const Process *p) {
+    return min(p->user_time + p->system_time, p->run_time);
+}
+
+/**
+ * Return timestamp as seconds for export (since the epoch for real
+ * processes, virtual seconds for simulated ones).
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   t       Timestamp.
+ **/
+static double stats_time(const Scheduler *s, Time t) {
+    return s->launch == LAUNCH_SIMULATE ? time_to_seconds(t) : timestamp_wall(t);
+}
+
+/**
+ * Write histogram summary row.
+ * @param   fs      File stream to write to.
+ * @param   name    Name of metric.
+ * @param   h       Pointer to Histogram structure.
+ * @param   unit    Nanoseconds per unit of the row (e.g. NSEC_PER_SEC).
+ **/
+static void stats_dump_histogram(FILE *fs, const char *name, const Histogram *h, Time unit) {
+    fprintf(fs, "%-12s %8lu %10.3lf", name, h->count, (double)histogram_mean(h) / unit);
+    for (size_t i = 0; i < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); i++) {
+        fprintf(fs, " %10.3lf", (double)histogram_percentile(h, PERCENTILES[i]) / unit);
+    }
+    fprintf(fs, " %10.3lf\n", (double)h->max / unit);
+}
+
+/**
+ * Display latency percentiles and resource usage of finished processes.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   fs      File stream to write to.
+ **/
+void scheduler_stats(Scheduler *s, FILE *fs) {
+    Time   user = 0, system = 0;
+    long   rss  = 0, voluntary = 0, involuntary = 0;
+
+    for (Process *p = s->finished.head; p; p = p->next) {
+        user        += p->user_time;
+        system      += p->system_time;
+        rss          = max(rss, p->max_rss);
+        voluntary   += p->voluntary_switches;
+        involuntary += p->involuntary_switches;
+    }
+
+    fprintf(fs, "\n%-12s %8s %10s %10s %10s %10s %10s\n", "METRIC", "COUNT", "MEAN", "P50", "P90", "P99", "MAX");
+    stats_dump_histogram(fs, "Turnaround", &s->turnaround, NSEC_PER_SEC);
+    stats_dump_histogram(fs, "Response",   &s->response, NSEC_PER_SEC);
+    stats_dump_histogram(fs, "Wait",       &s->wait, NSEC_PER_SEC);
+    if (s->deadlines) {
+        stats_dump_histogram(fs, "Lateness", &s->lateness, NSEC_PER_SEC);
+    }
+
+    if (s->instrument) {
+        Time lost = histogram_mean(&s->stop_latency);                 // outgoing job holds the core until it stops
+        fprintf(fs, "\n%-12s %8s %10s %10s %10s %10s %10s\n", "PREEMPT (us)", "COUNT", "MEAN", "P50", "P90", "P99", "MAX");
+        stats_dump_histogram(fs, "Stop",   &s->stop_latency, NSEC_PER_USEC);
+        stats_dump_histogram(fs, "Resume", &s->resume_latency, NSEC_PER_USEC);
+        fprintf(fs, "\nPreemptions = %lu, Stop Timeouts = %lu, Lost per Slice = %.1lf us (%.3lf%% of %.3lf ms)\n",
+            s->preemptions, s->stop_timeouts, (double)lost / NSEC_PER_USEC,
+            s->timeout ? 100.0 * lost / (s->timeout * NSEC_PER_USEC) : 0.0, s->timeout / 1000.0);
+        fprintf(fs, "Slices = %lu, Voluntary Switches = %ld, Involuntary Switches = %ld (%.2lf per slice)\n",
+            s->dispatches, s->voluntary_switches, s->involuntary_switches,
+            s->dispatches ? (double)s->involuntary_switches / s->dispatches : 0.0);
+    }
+
+    if (s->overhead > 0) {
+        fprintf(fs, "\nSlice = %.3lf ms, Switch Cost = %.3lf ms, Target Overhead = %.1lf%%, Burst P%d = %.3lf ms\n",
+            s->slice / 1000.0, (double)s->switch_cost / NSEC_PER_MSEC, s->overhead * 100.0,
+            SLICE_PERCENTILE, (double)s->burst / NSEC_PER_MSEC);
+    }
+
+    if (s->memory_limit > 0) {
+        fprintf(fs, "\nLimit = %lu, Memory Pressure = %.1lf%%, CPU Pressure = %.1lf%%, CPU Usage = %.2lf, Job RSS = %lu KB, Holds = %lu\n",
+            s->limit, s->memory_pressure * 100.0, s->cpu_pressure * 100.0, s->usage, s->job_rss / 1024, s->holds);
+    }
+
+    if (s->ntenants) {
+        Time total = 0;
+        for (size_t i = 0; i < s->ntenants; i++) {
+            total += s->tenants[i]->run_time;
+        }
+        fprintf(fs, "\n%-12s %8s %6s %8s %8s %8s %10s %6s\n", "TENANT", "WEIGHT", "POLICY", "RUNNING", "WAITING", "FINISHED", "RUN", "SHARE");
+        for (size_t i = 0; i < s->ntenants; i++) {
+            Tenant *t = s->tenants[i];
+            fprintf(fs, "%-12s %8.2lf %6s %8lu %8lu %8lu %10.3lf %5.1lf%%\n", t->name, t->weight,
+                t->policy == RDRN_POLICY ? "rdrn" : "fifo", t->running, t->waiting.size, t->finished,
+                time_to_seconds(t->run_time), total ? 100.0 * t->run_time / total : 0.0);
+        }
+    }
+
+    if (s->swap_sleeping) {
+        Time on = 0, off = 0;
+        for (Process *p = s->finished.head; p; p = p->next) {
+            on  += stats_on_cpu(p);
+            off += p->run_time - stats_on_cpu(p);
+        }
+        fprintf(fs, "\nSleep Swaps = %lu, On CPU = %.2lf, Off CPU = %.2lf (while holding a core)\n",
+            s->sleep_swaps, time_to_seconds(on), time_to_seconds(off));
+    }
+
+    if (s->launch == LAUNCH_SIMULATE) {
+        return;                                                     // no real processes to account
+    }
+    fprintf(fs, "\nUser = %.2lf, System = %.2lf, Max RSS = %ld KB, Voluntary = %ld, Involuntary = %ld\n",
+        time_to_seconds(user), time_to_seconds(system), rss, voluntary, involuntary);
+
+    if (s->capture.fd >= 0) {
+        fprintf(fs, "\nOutput = %lu bytes captured into %s\n",
+            s->capture.bytes, s->capture.directory ? s->capture.directory : "ring buffers");
+    }
+}
+
+/**
+ * Write string as a quoted JSON string.
+ * @param   fs      File stream to write to.
+ * @param   str     String to quote.
+ **/
+static void stats_json_string(FILE *fs, const char *str) {
+    fputc('"', fs);
+    for (; *str; str++) {
+        unsigned char c = *str;
+        if (c == '"' || c == '\\') {
+            fprintf(fs, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(fs, "\\u%04x", c);
+        } else {
+            fputc(c, fs);
+        }
+    }
+    fputc('"', fs);
+}
+
+/**
+ * Write histogram as a JSON object.
+ * @param   fs      File stream to write to.
+ * @param   h       Pointer to Histogram structure.
+ **/
+static void stats_json_histogram(FILE *fs, const Histogram *h) {
+    fprintf(fs, "{\"count\": %lu, \"mean\": %.9lf", h->count, time_to_seconds(histogram_mean(h)));
+    for (size_t i = 0; i < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); i++) {
+        fprintf(fs, ", \"p%.0lf\": %.9lf", PERCENTILES[i], time_to_seconds(histogram_percentile(h, PERCENTILES[i])));
+    }
+    fprintf(fs, ", \"max\": %.9lf}", time_to_seconds(h->max));
+}
+
+/**
+ * Write summary and finished processes as JSON.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   fs      File stream to write to.
+ **/
+static void stats_export_json(Scheduler *s, FILE *fs) {
+    fprintf(fs, "{\n  \"turnaround\": ");
+    stats_json_histogram(fs, &s->turnaround);
+    fprintf(fs, ",\n  \"response\": ");
+    stats_json_histogram(fs, &s->response);
+    fprintf(fs, ",\n  \"wait\": ");
+    stats_json_histogram(fs, &s->wait);
+    if (s->deadlines) {
+        fprintf(fs, ",\n  \"deadlines\": %lu,\n  \"deadline_misses\": %lu,\n  \"lateness\": ", s->deadlines, s->deadline_misses);
+        stats_json_histogram(fs, &s->lateness);
+    }
+    fprintf(fs, ",\n  \"jobs\": [");
+
+    for (Process *p = s->finished.head; p; p = p->next) {
+        fprintf(fs, "%s\n    {\"pid\": %d, \"command\": ", p == s->finished.head ? "" : ",", (int)p->pid);
+        stats_json_string(fs, p->command);
+        fprintf(fs, ", \"exit\": %d, \"arrival\": %.6lf, \"start\": %.6lf, \"end\": %.6lf, "
+                    "\"turnaround\": %.6lf, ",
+            stats_exit_code(p), stats_time(s, p->arrival_time), stats_time(s, p->start_time), stats_time(s, p->end_time),
+            time_to_seconds(p->end_time - p->arrival_time));
+        if (p->start_time) {
+            fprintf(fs, "\"response\": %.6lf, ", time_to_seconds(p->start_time - p->arrival_time));
+        } else {
+            fprintf(fs, "\"response\": null, ");
+        }
+        if (p->deadline) {
+            fprintf(fs, "\"deadline\": %.6lf, ", stats_time(s, p->deadline));
+        } else {
+            fprintf(fs, "\"deadline\": null, ");
+        }
+        if (p->tenant) {
+            fprintf(fs, "\"tenant\": ");
+            stats_json_string(fs, p->tenant->name);
+            fprintf(fs, ", ");
+        } else {
+            fprintf(fs, "\"tenant\": null, ");
+        }
+        fprintf(fs, "\"wait\": %.6lf, \"run\": %.6lf, \"on_cpu\": %.6lf, \"off_cpu\": %.6lf, "
+                    "\"user\": %.6lf, \"system\": %.6lf, "
+                    "\"max_rss\": %ld, \"voluntary\": %ld, \"involuntary\": %ld}",
+            time_to_seconds(p->end_time - p->arrival_time - p->run_time), time_to_seconds(p->run_time),
+            time_to_seconds(stats_on_cpu(p)), time_to_seconds(p->run_time - stats_on_cpu(p)),
+            time_to_seconds(p->user_time), time_to_seconds(p->system_time),
+            p->max_rss, p->voluntary_switches, p->involuntary_switches);
+    }
+    fprintf(fs, "\n  ]\n}\n");
+}
+
+/**
+ * Write string as a quoted CSV field.
+ * @param   fs      File stream to write to.
+ * @param   str     String to quote.
+ **/
+static void stats_csv_string(FILE *fs, const char *str) {
+    fputc('"', fs);
+    for (; *str; str++) {
+        if (*str == '"') fputc('"', fs);                        // quotes are doubled
+        fputc(*str, fs);
+    }
+    fputc('"', fs);
+}
+
+/**
+ * Write finished processes as CSV.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   fs      File stream to write to.
+ **/
+static void stats_export_csv(Scheduler *s, FILE *fs) {
+    fprintf(fs, "pid,command,exit,arrival,start,end,turnaround,response,wait,run,on_cpu,off_cpu,"
+                "user,system,max_rss,voluntary,involuntary,deadline,tenant\n");
+
+    for (Process *p = s->finished.head; p; p = p->next) {
+        fprintf(fs, "%d,", (int)p->pid);
+        stats_csv_string(fs, p->command);
+        fprintf(fs, ",%d,%.6lf,%.6lf,%.6lf,%.6lf,", stats_exit_code(p),
+            stats_time(s, p->arrival_time), stats_time(s, p->start_time), stats_time(s, p->end_time),
+            time_to_seconds(p->end_time - p->arrival_time));
+        if (p->start_time) {
+            fprintf(fs, "%.6lf", time_to_seconds(p->start_time - p->arrival_time));
+        }
+        fprintf(fs, ",%.6lf,%.6lf,%.6lf,%.6lf,%.6lf,%.6lf,%ld,%ld,%ld,",
+            time_to_seconds(p->end_time - p->arrival_time - p->run_time), time_to_seconds(p->run_time),
+            time_to_seconds(stats_on_cpu(p)), time_to_seconds(p->run_time - stats_on_cpu(p)),
+            time_to_seconds(p->user_time), time_to_seconds(p->system_time),
+            p->max_rss, p->voluntary_switches, p->involuntary_switches);
+        if (p->deadline) {
+            fprintf(fs, "%.6lf", stats_time(s, p->deadline));
+        }
+        fputc(',', fs);
+        if (p->tenant) {
+            stats_csv_string(fs, p->tenant->name);
+        }
+        fputc('\n', fs);
+    }
+}
+
+/**
+ * Write metrics of finished processes to file (JSON if the path ends in
+ * .json, otherwise CSV).
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   path    Path to metrics file.
+ * @return  Whether or not the file was written.
+ **/
+bool scheduler_export(Scheduler *s, const char *path) {
+    FILE *fs = fopen(path, "w");
+    if (!fs) {
+        error("Unable to open %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    size_t length = strlen(path);
+    if (length >= 5 && streq(path + length - 5, ".json")) {
+        stats_export_json(s, fs);
+    } else {
+        stats_export_csv(s, fs);
+    }
+
+    if (fclose(fs) != 0) {
+        error("Unable to write %s: %s", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,112 @@
+/* scheduler_stride.c: PQSH Stride Scheduler */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/process.h"
+#include "../include/pqsh/timestamp.h"
+
+/**
+ * Order processes by pass (ties broken by insertion order).
+ **/
+static int stride_compare(const RBNode *a, const RBNode *b) {
+    const Process *pa = container_of(a, Process, node);
+    const Process *pb = container_of(b, Process, node);
+
+    if (pa->pass < pb->pass) return -1;
+    if (pa->pass > pb->pass) return  1;
+    return 0;
+}
+
+/**
+ * Return pass of running process including its current slice.
+ * @param   p       Running process
+ * @param   now     Current timestamp
+ **/
+static Time stride_pass(Process *p, Time now) {
+    return p->pass + (now - p->dispatch_time) * TICKETS_DEFAULT / (Time)p->tickets;
+}
+
+/**
+ * Return running process with the highest pass.
+ * @param   s	    Scheduler structure
+ * @param   now     Current timestamp
+ **/
+static Process *stride_victim(Scheduler *s, Time now) {
+    Process *victim = NULL;
+    for (Process *p = s->running.head; p; p = p->next) {
+        if (!victim || stride_pass(p, now) > stride_pass(victim, now)) {
+            victim = p;
+        }
+    }
+    return victim;
+}
+
+/**
+ * Start or resume the process with the lowest pass.
+ * @param   s	    Scheduler structure
+ **/
+static void stride_dispatch(Scheduler *s) {
+    Process *p = container_of(rbtree_first(&s->tree), Process, node);
+    rbtree_remove(&s->tree, &p->node);
+    scheduler_dispatch(s, p);
+}
+
+/**
+ * Schedule next process using stride policy:
+ *
+ *  1. New arrivals are placed in the tree with the current minimum pass so
+ *  they neither starve nor are starved by existing processes.
+ *
+ *  2. While the running process with the highest pass is ahead of the
+ *  waiting process with the lowest pass, swap them (every timer interrupt,
+ *  as with round robin).
+ *
+ *  3. Idle cores take the waiting processes with the lowest pass.
+ *
+ *  A process's pass advances by its time on a core times its stride
+ *  (TICKETS_DEFAULT / tickets), so a process with three times the tickets
+ *  deterministically receives three times the share of a core.
+ *
+ * @param   s	    Scheduler structure
+ **/
+void scheduler_stride(Scheduler *s) {
+    Time     now = timestamp();
+    Process *p;
+
+    /* Arrivals */
+    while ((p = queue_pop(&s->waiting))) {
+        p->pass = max(p->pass, s->global_pass);
+        rbtree_insert(&s->tree, &p->node, stride_compare);
+    }
+
+    /* Preemption */
+    while (s->tree.size && s->running.size >= s->cores) {
+        Process *victim = stride_victim(s, now);
+        Process *first  = container_of(rbtree_first(&s->tree), Process, node);
+
+        if (stride_pass(victim, now) <= first->pass) {
+            break;
+        }
+        victim->pass = stride_pass(victim, now);
+        scheduler_preempt(s, victim);
+        rbtree_insert(&s->tree, &victim->node, stride_compare);
+        stride_dispatch(s);
+    }
+
+    /* Fill idle cores */
+    while (s->running.size < s->cores && s->tree.size) {
+        stride_dispatch(s);
+    }
+
+    /* Track monotonic minimum pass */
+    if (s->tree.size || s->running.size) {
+        Time minimum = s->tree.size ?
+            container_of(rbtree_first(&s->tree), Process, node)->pass : stride_pass(s->running.head, now);
+        for (p = s->running.head; p; p = p->next) {
+            minimum = min(minimum, stride_pass(p, now));
+        }
+        s->global_pass = max(s->global_pass, minimum);
+    }
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
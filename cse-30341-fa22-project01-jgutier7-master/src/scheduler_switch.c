@@ -0,0 +1,79 @@
+/* scheduler_switch.c: PQSH Preemption Cost Instrumentation */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/scheduler.h"
+#include "../include/pqsh/process.h"
+#include "../include/pqsh/procfs.h"
+#include "../include/pqsh/timestamp.h"
+
+/**
+ * Account context switches of process since it was last sampled.
+ * @param   s	        Pointer to Scheduler structure.
+ * @param   p           Pointer to Process.
+ * @param   voluntary   Voluntary context switches of process so far.
+ * @param   involuntary Involuntary context switches of process so far.
+ **/
+void scheduler_switch_sample(Scheduler *s, Process *p, long voluntary, long involuntary) {
+    s->voluntary_switches   += voluntary - p->voluntary_switches;
+    s->involuntary_switches += involuntary - p->involuntary_switches;
+    p->voluntary_switches    = voluntary;
+    p->involuntary_switches  = involuntary;
+}
+
+/**
+ * Measure pause of running process: remember when SIGSTOP was sent (the stop
+ * itself is reported later by SIGCHLD, see scheduler_switch_stopped).
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to paused Process.
+ * @param   begin   Time SIGSTOP was sent.
+ **/
+void scheduler_switch_pause(Scheduler *s, Process *p, Time begin) {
+    p->stop_time = begin;
+}
+
+/**
+ * Measure stop of paused process: the time from SIGSTOP until the stop is
+ * reaped (its core is only really free then), and the context switches it
+ * made while it held the core. Stops reaped later than STOP_LIMIT count as
+ * timeouts.
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to stopped Process.
+ * @param   now     Time stop was reaped.
+ **/
+void scheduler_switch_stopped(Scheduler *s, Process *p, Time now) {
+    long voluntary, involuntary;
+
+    if (!p->stop_time) {
+        return;                                                     // resumed before the stop was reported
+    }
+    if (now - p->stop_time <= STOP_LIMIT) {
+        histogram_record(&s->stop_latency, now - p->stop_time);
+    } else {
+        s->stop_timeouts++;
+    }
+    p->stop_time = 0;
+    if (procfs_switches(p->pid, &voluntary, &involuntary)) {
+        scheduler_switch_sample(s, p, voluntary, involuntary);
+    }
+}
+
+/**
+ * Measure resume of paused process (re-pinning and SIGCONT).
+ *
+ * When jobs outnumber CPUs, this includes the time the shell waits for a CPU
+ * after the resumed process preempts it. A stop still unreported at this
+ * point counts as a timeout.
+ *
+ * @param   s	    Pointer to Scheduler structure.
+ * @param   p       Pointer to resumed Process.
+ * @param   begin   Time resume started.
+ **/
+void scheduler_switch_resume(Scheduler *s, Process *p, Time begin) {
+    if (p->stop_time) {
+        s->stop_timeouts++;
+        p->stop_time = 0;
+    }
+    histogram_record(&s->resume_latency, timestamp() - begin);
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
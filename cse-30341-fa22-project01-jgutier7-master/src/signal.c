@@ -1,7 +1,6 @@
 /* signal.c: PQSH Signal Handlers */
 
 #include "../include/pqsh/macros.h"
-#include "../include/pqsh/scheduler.h"
 #include "../include/pqsh/signal.h"
 
 #include <errno.h>
@@ -9,6 +8,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
 
 /**
  * Register signal handler with specified flags.
@@ -30,14 +31,41 @@ bool signal_register(int signum, int flags, sighandler_t handler) {
 }
 
 /**
- * SIGALRM handler.
+ * Block signal and open a file descriptor that becomes readable whenever the
+ * signal is pending.
  * @param   signum      Signal number.
+ * @return  Signal file descriptor (-1 on failure).
  **/
-void sigalrm_handler(int signum) {
-    /* TODO: Handle timer event. */ 
-    extern Scheduler PQShellScheduler;
-    scheduler_wait(&PQShellScheduler);
-    scheduler_next(&PQShellScheduler);
+int signal_open(int signum) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, signum);
+
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0) {
+        error("Failed to block signal: %s", strerror(errno));
+        return -1;
+    }
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+        error("Failed to open signalfd: %s", strerror(errno));
+    }
+    return fd;
+}
+
+/**
+ * Consume all pending signals on signal file descriptor.
+ * @param   fd          Signal file descriptor.
+ * @return  Number of signals consumed.
+ **/
+size_t signal_drain(int fd) {
+    struct signalfd_siginfo info;
+    size_t count = 0;
+
+    while (read(fd, &info, sizeof(info)) == sizeof(info)) {
+        count++;
+    }
+    return count;
 }
 
 /* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,251 @@
+/* simulator.c: PQSH Discrete-Event Simulator */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/intern.h"
+#include "../include/pqsh/simulator.h"
+#include "../include/pqsh/timestamp.h"
+
+#include <float.h>
+
+/**
+ * Order jobs by arrival time, then by position in trace.
+ **/
+static int simulator_compare_arrival(const void *a, const void *b) {
+    const SimJob *x = a, *y = b;
+
+    if (x->arrival < y->arrival) return -1;
+    if (x->arrival > y->arrival) return  1;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+/**
+ * Order jobs blocked on I/O by completion time.
+ **/
+static int simulator_compare_io(const RBNode *a, const RBNode *b) {
+    double x = container_of(a, SimJob, node)->io_until;
+    double y = container_of(b, SimJob, node)->io_until;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Load workload trace.
+ *
+ * Each line has the form: ARRIVAL BURST [IO_PERIOD IO_TIME [COMMAND]]
+ *
+ *  - ARRIVAL is when the job is added (seconds from start of trace).
+ *  - BURST is the CPU time the job needs (seconds).
+ *  - Every IO_PERIOD seconds of CPU the job blocks for IO_TIME seconds; the
+ *    I/O completes whether or not the job is paused.
+ *  - COMMAND names the job (jobs sharing a command share SRTF history).
+ *
+ * Blank lines and lines starting with # are ignored.
+ *
+ * @param   sim         Pointer to Simulator structure.
+ * @param   fs          Input file stream.
+ * @return  Whether or not the trace was loaded.
+ **/
+bool simulator_load(Simulator *sim, FILE *fs) {
+    char   buffer[BUFSIZ];
+    size_t line = 0;
+
+    while (fgets(buffer, BUFSIZ, fs)) {
+        SimJob job    = {0};
+        int    offset = 0;
+
+        line++;
+        chomp(buffer);
+        int fields = sscanf(buffer, " %lf %lf %lf %lf %n", &job.arrival, &job.burst, &job.io_period, &job.io_time, &offset);
+        if (fields <= 0) {                                          // blank line or comment
+            continue;
+        }
+        if (fields == 1 || fields == 3 || job.arrival < 0 || job.burst < 0 || job.io_period < 0 || job.io_time < 0) {
+            error("Invalid job on line %lu: %s", line, buffer);
+            return false;
+        }
+        if (fields == 2) {
+            job.io_period = job.io_time = 0;
+            offset = strlen(buffer);
+        }
+
+        if (sim->size == sim->capacity) {
+            size_t  capacity = sim->capacity ? sim->capacity * 2 : 1024;
+            SimJob *jobs     = realloc(sim->jobs, capacity * sizeof(SimJob));
+            if (!jobs) {
+                return false;
+            }
+            sim->jobs     = jobs;
+            sim->capacity = capacity;
+        }
+
+        job.id      = sim->size;
+        job.command = intern_acquire(buffer[offset] ? buffer + offset : "job");
+        if (!job.command) {
+            return false;
+        }
+        sim->jobs[sim->size++] = job;
+    }
+
+    qsort(sim->jobs, sim->size, sizeof(SimJob), simulator_compare_arrival);
+    return true;
+}
+
+/**
+ * Start next CPU phase of job.
+ **/
+static void simulator_phase(SimJob *job) {
+    job->io             = false;
+    job->process->state = 'R';
+    job->phase          = job->io_period > 0 ? min(job->io_period, job->left) : job->left;
+}
+
+/**
+ * Add job to scheduler as if entered at the shell (arrivals only dispatch
+ * onto idle cores, or preempt a later deadline under edf and a longer
+ * remaining time under srtf).
+ **/
+static bool simulator_arrive(Simulator *sim, Scheduler *s, SimJob *job) {
+    Process *p = scheduler_add(s, NULL, job->command);
+    if (!p) {
+        return false;
+    }
+
+    job->left    = job->burst;
+    job->process = p;
+    simulator_phase(job);
+    p->data = job;
+    sim->arrived++;
+
+    if (s->running.size < s->limit || s->policy == EDF_POLICY || s->policy == SRTF_POLICY) {
+        scheduler_next(s);
+    }
+    return true;
+}
+
+/**
+ * Run the scheduler against the workload on a virtual clock.
+ *
+ * Instead of processes, signals, and timers, the simulator advances time to
+ * the next event (arrival, end of a CPU phase, end of an I/O, or timer
+ * interrupt) and calls the same scheduler functions the shell's event
+ * handlers do. CPU phases only progress while a job is in the running queue.
+ *
+ * @param   sim         Pointer to Simulator structure.
+ * @param   s           Pointer to Scheduler structure (launch must be LAUNCH_SIMULATE).
+ * @return  Whether or not every job finished.
+ **/
+bool simulator_run(Simulator *sim, Scheduler *s) {
+    double quantum   = (double)s->timeout / 1000000.0;
+    double next_tick = quantum;
+
+    if (quantum <= 0 || s->launch != LAUNCH_SIMULATE) {
+        error("Simulation requires a positive time slice and simulated launches");
+        return false;
+    }
+
+    timestamp_virtual(time_from_seconds(SIMULATOR_EPOCH));
+    s->trace.origin = time_from_seconds(SIMULATOR_EPOCH);
+
+    while (sim->finished < sim->size) {
+        /* Find next event */
+        double next = DBL_MAX;
+        if (sim->arrived < sim->size) {
+            next = sim->jobs[sim->arrived].arrival;
+        }
+        for (Process *p = s->running.head; p; p = p->next) {
+            SimJob *job = p->data;
+            if (!job->io) {
+                next = min(next, sim->now + job->phase);
+            }
+        }
+        if (sim->io.size) {
+            next = min(next, container_of(rbtree_first(&sim->io), SimJob, node)->io_until);
+        }
+
+        if (s->running.size || scheduler_waiting(s) || sim->io.size) {
+            next = min(next, next_tick);
+        } else if (next == DBL_MAX) {
+            error("Simulation stalled with %lu of %lu jobs finished", sim->finished, sim->size);
+            break;
+        } else if (next_tick < next) {                              // skip ticks while idle
+            next_tick += (size_t)((next - next_tick) / quantum) * quantum;
+            while (next_tick < next) next_tick += quantum;
+        }
+
+        /* Advance clock */
+        for (Process *p = s->running.head; p; p = p->next) {
+            SimJob *job = p->data;
+            if (!job->io) {
+                job->phase -= next - sim->now;
+                job->left  -= next - sim->now;
+            }
+        }
+        sim->now = max(sim->now, next);
+        timestamp_virtual(time_from_seconds(SIMULATOR_EPOCH + sim->now));
+
+        /* Arrivals */
+        while (sim->arrived < sim->size && sim->jobs[sim->arrived].arrival <= sim->now + SIMULATOR_EPSILON) {
+            if (!simulator_arrive(sim, s, &sim->jobs[sim->arrived])) {
+                return false;
+            }
+        }
+
+        /* I/O completions */
+        RBNode *n;
+        while ((n = rbtree_first(&sim->io)) && container_of(n, SimJob, node)->io_until <= sim->now + SIMULATOR_EPSILON) {
+            rbtree_remove(&sim->io, n);
+            simulator_phase(container_of(n, SimJob, node));
+        }
+
+        /* CPU phase completions (exits behave like SIGCHLD) */
+        size_t exited = 0;
+        for (Process *next_p, *p = s->running.head; p; p = next_p) {
+            SimJob *job = p->data;
+            next_p = p->next;
+            if (job->io || job->phase > SIMULATOR_EPSILON) {
+                continue;
+            }
+
+            if (job->left <= SIMULATOR_EPSILON) {
+                scheduler_exit(s, p, 0, NULL);
+                sim->finished++;
+                exited++;
+            } else {
+                job->io       = true;
+                job->io_until = sim->now + job->io_time;
+                p->state      = 'D';
+                rbtree_insert(&sim->io, &job->node, simulator_compare_io);
+            }
+        }
+        if (exited) {
+            scheduler_next(s);
+        }
+
+        /* Timer interrupt */
+        if (sim->now + SIMULATOR_EPSILON >= next_tick) {
+            if (s->overhead > 0) {                                  // preemption is free, so only bursts matter
+                quantum = (double)scheduler_slice(s) / 1000000.0;
+            }
+            next_tick += quantum;
+            scheduler_next(s);
+        }
+    }
+
+    timestamp_virtual(0);
+    return sim->finished == sim->size;
+}
+
+/**
+ * Release workload.
+ * @param   sim         Pointer to Simulator structure.
+ **/
+void simulator_release(Simulator *sim) {
+    for (size_t i = 0; i < sim->size; i++) {
+        intern_release(sim->jobs[i].command);
+    }
+    free(sim->jobs);
+    sim->jobs     = NULL;
+    sim->size     = 0;
+    sim->capacity = 0;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,96 @@
+/* slab.c: PQSH Slab Allocator */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/slab.h"
+
+#include <stdbool.h>
+
+/**
+ * Add new chunk of objects to the slab's free list.
+ *
+ * Each chunk starts with a SLAB_ALIGN sized header linking it to the previous
+ * chunk, followed by as many objects as fit in SLAB_CHUNK bytes (at least one).
+ *
+ * @param   s           Pointer to Slab structure.
+ * @return  Whether or not the chunk was allocated.
+ **/
+static bool slab_grow(Slab *s) {
+    size_t count = max((SLAB_CHUNK - SLAB_ALIGN) / s->size, (size_t)1);
+    char  *chunk = malloc(SLAB_ALIGN + count * s->size);
+    if (!chunk) {
+        return false;
+    }
+
+    *(void **)chunk = s->chunks;
+    s->chunks = chunk;
+
+    for (size_t i = count; i > 0; i--) {
+        void **object = (void **)(chunk + SLAB_ALIGN + (i - 1) * s->size);
+        *object = s->free;
+        s->free = object;
+    }
+    s->capacity += count;
+    return true;
+}
+
+/**
+ * Allocate zeroed object from slab.
+ * @param   s           Pointer to Slab structure.
+ * @return  Pointer to object (NULL on failure).
+ **/
+void *slab_alloc(Slab *s) {
+    if (!s->free && !slab_grow(s)) {
+        return NULL;
+    }
+
+    void **object = s->free;
+    s->free = *object;
+    s->used++;
+    return memset(object, 0, s->size);
+}
+
+/**
+ * Return object to slab (chunks are kept for reuse until trimmed or released).
+ * @param   s           Pointer to Slab structure.
+ * @param   object      Pointer to object allocated with slab_alloc.
+ **/
+void slab_free(Slab *s, void *object) {
+    if (!object) {
+        return;
+    }
+
+    *(void **)object = s->free;
+    s->free = object;
+    s->used--;
+}
+
+/**
+ * Release all chunks in slab if no objects are outstanding.
+ * @param   s           Pointer to Slab structure.
+ * @return  Whether or not the chunks were released.
+ **/
+bool slab_trim(Slab *s) {
+    if (s->used) {
+        return false;
+    }
+    slab_release(s);
+    return true;
+}
+
+/**
+ * Release all chunks in slab (invalidating any outstanding objects).
+ * @param   s           Pointer to Slab structure.
+ **/
+void slab_release(Slab *s) {
+    while (s->chunks) {
+        void *next = *(void **)s->chunks;
+        free(s->chunks);
+        s->chunks = next;
+    }
+
+    s->free     = NULL;
+    s->used     = 0;
+    s->capacity = 0;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
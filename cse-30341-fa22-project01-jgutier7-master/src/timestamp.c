@@ -2,28 +2,129 @@
 
 #include "../include/pqsh/timestamp.h"
 #include <time.h>
-#include <sys/time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TIMESTAMP_HAVE_TSC
+#endif
+
+/* Globals */
+
+static Time VirtualTime = 0;        /* Simulated clock (0 == use monotonic clock) */
+static Time WallOffset  = 0;        /* Realtime minus monotonic time (0 == not measured yet) */
+
+#ifdef TIMESTAMP_HAVE_TSC
+static bool     TscEnabled = false; /* Whether or not timestamps come from the TSC */
+static uint64_t TscBase    = 0;     /* TSC at calibration */
+static Time     TscOrigin  = 0;     /* Monotonic time at calibration */
+static uint64_t TscScale   = 0;     /* Nanoseconds per tick (32.32 fixed point) */
+#endif
+
+/**
+ * Return time of clock in nanoseconds.
+ * @param   clock       Clock to read.
+ **/
+static Time timestamp_clock(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
 
 /**
- * Return current timestamp as a double.
+ * Return current monotonic timestamp.
  *
- * Utilizes gettimeofday for precision (accounting for seconds and
- * microseconds) and falls back to time (only account for seconds) if that
- * fails.
+ * Utilizes CLOCK_MONOTONIC, which never jumps or runs backwards when the
+ * wall clock is set or slewed, or the calibrated TSC if enabled.
  *
- * @return  Double representing the current time.
+ * @return  Nanoseconds since an arbitrary (per boot) origin.
+ **/
+Time timestamp() {
+    if (VirtualTime) {                                                              // simulated clock
+        return VirtualTime;
+    }
+
+#ifdef TIMESTAMP_HAVE_TSC
+    if (TscEnabled) {
+        return TscOrigin + (Time)(((unsigned __int128)(__rdtsc() - TscBase) * TscScale) >> 32);
+    }
+#endif
+    return timestamp_clock(CLOCK_MONOTONIC);
+}
+
+/**
+ * Replace the monotonic clock with a simulated one.
+ * @param   now         Simulated time returned by timestamp (0 == restore monotonic clock).
+ **/
+void timestamp_virtual(Time now) {
+    VirtualTime = now;
+}
+
+/**
+ * Switch timestamps to the TSC, calibrated against CLOCK_MONOTONIC by
+ * spinning for TIMESTAMP_CALIBRATION.
+ *
+ * Only an invariant TSC (constant rate, synchronized across cores) is used.
+ * The TSC is not slewed like CLOCK_MONOTONIC, so the two drift apart by the
+ * calibration error (a few parts per million).
+ *
+ * @return  Whether or not the TSC is now used.
+ **/
+bool timestamp_tsc() {
+#ifdef TIMESTAMP_HAVE_TSC
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8))) {
+        return false;
+    }
+
+    Time     start = timestamp_clock(CLOCK_MONOTONIC);
+    uint64_t base  = __rdtsc();
+    Time     now;
+    while ((now = timestamp_clock(CLOCK_MONOTONIC)) - start < TIMESTAMP_CALIBRATION);
+    uint64_t ticks = __rdtsc() - base;
+    if (!ticks) {
+        return false;
+    }
+
+    TscScale   = ((uint64_t)(now - start) << 32) / ticks;
+    TscBase    = base;
+    TscOrigin  = start;
+    TscEnabled = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Convert monotonic timestamp to seconds since the epoch (for display and
+ * for records that outlive the process).
+ * @param   t           Monotonic timestamp (0 == never).
+ * @return  Seconds since the epoch (0 if t is 0).
+ **/
+double timestamp_wall(Time t) {
+    if (!t) {
+        return 0;
+    }
+    if (!WallOffset) {
+        WallOffset = timestamp_clock(CLOCK_REALTIME) - timestamp_clock(CLOCK_MONOTONIC);
+    }
+    return time_to_seconds(t + WallOffset);
+}
+
+/**
+ * Convert seconds since the epoch to a monotonic timestamp.
+ * @param   seconds     Seconds since the epoch (0 == never).
+ * @return  Monotonic timestamp (0 if seconds is 0).
  **/
-double timestamp() {
-    double time_stamp;                                                              // return value 
-    struct timeval timed;                                                           // time variable to hold the struct returned by gettimeofday
- 
-    if(gettimeofday(&timed,NULL) != 0){                                             // gets time of day && check if fails
-        time_t seconds = time(NULL);                                            
-        return seconds;                                                             // returns seconds instead
-    } 
-
-    time_stamp = (double)timed.tv_sec+((double)timed.tv_usec / 1000000.0);          //converts time of day into seconds 
-    return time_stamp;                                                              //returns the time of day in seconds 
+Time timestamp_from_wall(double seconds) {
+    if (!seconds) {
+        return 0;
+    }
+    if (!WallOffset) {
+        WallOffset = timestamp_clock(CLOCK_REALTIME) - timestamp_clock(CLOCK_MONOTONIC);
+    }
+    return time_from_seconds(seconds) - WallOffset;
 }
 
 /* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
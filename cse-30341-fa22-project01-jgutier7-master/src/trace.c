@@ -0,0 +1,127 @@
+/* trace.c: PQSH Scheduling Trace */
+
+#include "../include/pqsh/macros.h"
+#include "../include/pqsh/timestamp.h"
+#include "../include/pqsh/trace.h"
+
+#include <errno.h>
+#include <string.h>
+
+/* Constants */
+
+static const char *TRACE_NAMES[] = {
+    [TRACE_ARRIVAL] = "arrival",
+    [TRACE_START]   = "start",
+    [TRACE_PAUSE]   = "pause",
+    [TRACE_RESUME]  = "resume",
+    [TRACE_EXIT]    = "exit",
+};
+
+#define TRACE_ARRIVALS  -1      /* Thread id of arrivals track */
+
+/**
+ * Allocate ring buffer and start tracing.
+ * @param   t           Pointer to Trace structure.
+ * @param   capacity    Number of events to keep.
+ * @return  Whether or not the ring buffer was allocated.
+ **/
+bool trace_init(Trace *t, size_t capacity) {
+    t->events   = calloc(capacity, sizeof(TraceEvent));
+    t->capacity = capacity;
+    t->count    = 0;
+    t->origin   = timestamp();
+    return t->events != NULL;
+}
+
+/**
+ * Write string as a quoted JSON string.
+ * @param   fs          Output file stream.
+ * @param   s           String to quote.
+ **/
+static void trace_string(FILE *fs, const char *s) {
+    fputc('"', fs);
+    for (; *s; s++) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\') {
+            fprintf(fs, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(fs, "\\u%04x", c);
+        } else {
+            fputc(c, fs);
+        }
+    }
+    fputc('"', fs);
+}
+
+/**
+ * Write buffered events as Chrome trace-event JSON (viewable in Perfetto or
+ * chrome://tracing).
+ *
+ * Each core is a thread whose slices are the processes running on it; a
+ * separate thread holds an instant event per arrival.
+ *
+ * @param   t           Pointer to Trace structure.
+ * @param   path        Path to trace file.
+ * @return  Whether or not the trace was written.
+ **/
+bool trace_flush(Trace *t, const char *path) {
+    FILE *fs = fopen(path, "w");
+    if (!fs) {
+        error("Unable to open %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    size_t first = t->count > t->capacity ? t->count - t->capacity : 0;
+    int    cores = 0;
+
+    fprintf(fs, "{\"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped\": %lu}, \"traceEvents\": [\n", first);
+    fprintf(fs, "{\"ph\": \"M\", \"pid\": 1, \"name\": \"process_name\", \"args\": {\"name\": \"pqsh\"}},\n");
+    fprintf(fs, "{\"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"name\": \"thread_name\", \"args\": {\"name\": \"Arrivals\"}}",
+        TRACE_ARRIVALS);
+
+    for (size_t i = first; i < t->count; i++) {
+        TraceEvent *e  = &t->events[i % t->capacity];
+        double      ts = (double)(e->time - t->origin) / NSEC_PER_USEC;
+
+        while (e->core >= cores) {
+            fprintf(fs, ",\n{\"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"name\": \"thread_name\", \"args\": {\"name\": \"Core %d\"}}",
+                cores, cores);
+            cores++;
+        }
+
+        const char *phase;
+        switch (e->type) {
+            case TRACE_START:
+            case TRACE_RESUME:  phase = "B"; break;
+            case TRACE_PAUSE:   phase = "E"; break;
+            case TRACE_EXIT:    phase = e->core >= 0 ? "E" : "i"; break;
+            default:            phase = "i"; break;
+        }
+
+        fprintf(fs, ",\n{\"ph\": \"%s\", \"pid\": 1, \"tid\": %d, \"ts\": %.3lf, \"name\": ",
+            phase, e->core >= 0 ? e->core : TRACE_ARRIVALS, ts);
+        trace_string(fs, e->command);
+        fprintf(fs, ", \"args\": {\"pid\": %d, \"event\": \"%s\"}%s}",
+            e->pid, TRACE_NAMES[e->type], phase[0] == 'i' ? ", \"s\": \"t\"" : "");
+    }
+    fprintf(fs, "\n]}\n");
+
+    if (fclose(fs) != 0) {
+        error("Unable to write %s: %s", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Release ring buffer.
+ * @param   t           Pointer to Trace structure.
+ **/
+void trace_release(Trace *t) {
+    free(t->events);
+    t->events   = NULL;
+    t->capacity = 0;
+    t->count    = 0;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
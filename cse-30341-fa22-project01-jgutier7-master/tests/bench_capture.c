@@ -0,0 +1,116 @@
+/* bench_capture.c: Benchmark PQSH Job Output Capture */
+
+#define _GNU_SOURCE
+
+#include "pqsh/macros.h"
+#include "pqsh/capture.h"
+#include "pqsh/process.h"
+#include "pqsh/timestamp.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+
+/* Constants */
+
+#define CAPTURE_DIRECTORY   "bench_capture.d"
+
+const struct {
+    const char *name;
+    bool        log;        /* Capture into log file (else ring buffer) */
+    bool        copy;       /* Read and write through user space instead of splice */
+} MODES[] = {
+    { "splice", true,  false },
+    { "copy",   true,  true },
+    { "ring",   false, false },
+};
+
+/* Functions */
+
+/* Read and write pipe into log file, as capture would without splice */
+size_t capture_copy(Output *o, int log) {
+    static char buffer[CAPTURE_QUANTUM];
+    size_t moved = 0;
+    ssize_t n;
+
+    while ((n = read(o->fd, buffer, sizeof(buffer))) > 0 && write(log, buffer, n) == n) {
+        moved += n;
+    }
+    if (n == 0) {
+        close(o->fd);
+        o->fd = -1;
+    }
+    return moved;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 512;
+    char   command[BUFSIZ];
+    char   path[BUFSIZ];
+
+    if (argc > 2 || !megabytes) {
+        fprintf(stderr, "Usage: %s [MEGABYTES]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    snprintf(command, BUFSIZ, "head -c %luM /dev/zero", megabytes);
+
+    printf("%-6s %8s %10s %10s %10s\n", "MODE", "MB", "SECONDS", "MB/S", "CPU");
+    for (size_t m = 0; m < sizeof(MODES) / sizeof(MODES[0]); m++) {
+        Capture c = { .directory = MODES[m].log ? CAPTURE_DIRECTORY : NULL };
+        if (!capture_init(&c)) {
+            return EXIT_FAILURE;
+        }
+
+        Process *p = process_create(command);
+        if (!p || !(p->output = capture_open(&c))) {
+            return EXIT_FAILURE;
+        }
+
+        Time    start = timestamp();
+        clock_t cpu   = clock();
+        if (!process_launch(p, LAUNCH_SPAWN) || !capture_start(&c, p->output, p->pid)) {
+            return EXIT_FAILURE;
+        }
+
+        int log = -1;
+        snprintf(path, BUFSIZ, "%s", p->output->path ? p->output->path : "");
+        if (MODES[m].copy) {                                        // take the log file from capture
+            log = p->output->log;
+            p->output->log = -1;
+        }
+
+        struct epoll_event event;
+        while (p->output->fd >= 0) {
+            if (epoll_wait(c.fd, &event, 1, -1) < 0 && errno != EINTR) {
+                return EXIT_FAILURE;
+            }
+            if (MODES[m].copy) {
+                c.bytes += capture_copy(p->output, log);
+            } else {
+                capture_read(&c, p->output, CAPTURE_QUANTUM);
+            }
+        }
+        double elapsed = time_to_seconds(timestamp() - start);
+        double seconds = (double)(clock() - cpu) / CLOCKS_PER_SEC;
+        waitpid(p->pid, NULL, 0);
+
+        printf("%-6s %8lu %10.3lf %10.1lf %10.3lf\n", MODES[m].name, c.bytes >> 20, elapsed,
+            (c.bytes >> 20) / elapsed, seconds);
+
+        if (log >= 0) {
+            close(log);
+        }
+        process_delete(p);
+        capture_release(&c);
+        unlink(path);
+    }
+
+    rmdir(CAPTURE_DIRECTORY);
+    return EXIT_SUCCESS;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
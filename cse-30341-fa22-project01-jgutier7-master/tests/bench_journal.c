@@ -0,0 +1,123 @@
+/* bench_journal.c: Benchmark PQSH Write-Ahead Journal */
+
+#include "pqsh/macros.h"
+#include "pqsh/scheduler.h"
+#include "pqsh/timestamp.h"
+
+#include <string.h>
+#include <unistd.h>
+
+/* Constants */
+
+#define JOURNAL_PATH    "bench_journal.log"
+#define TARGET          100000      /* Required submissions per second */
+
+const struct {
+    const char *name;
+    bool        journal;
+    size_t      batch;              /* Submissions per commit (0 == never) */
+    size_t      limit;              /* Maximum submissions (0 == all) */
+} MODES[] = {
+    { "none",   false, 0,    0 },
+    { "group",  true,  1000, 0 },
+    { "group",  true,  100,  0 },
+    { "each",   true,  1,    2000 },
+};
+
+/* Functions */
+
+Scheduler *scheduler_create(bool journal) {
+    Scheduler *s = calloc(1, sizeof(Scheduler));
+    if (!s) {
+        return NULL;
+    }
+
+    s->policy       = FIFO_POLICY;
+    s->cores        = 1;
+    s->timeout      = 250000;
+    s->launch       = LAUNCH_SIMULATE;
+    s->journal_path = journal ? JOURNAL_PATH : NULL;
+    if (!scheduler_init(s) || (journal && !scheduler_recover(s))) {
+        scheduler_release(s);
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+void scheduler_delete(Scheduler *s) {
+    scheduler_release(s);
+    free(s);
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    size_t submissions = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    int    status      = EXIT_SUCCESS;
+    char   command[BUFSIZ];
+
+    if (argc > 2 || !submissions) {
+        fprintf(stderr, "Usage: %s [SUBMISSIONS]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%-6s %6s %8s %8s %10s %12s\n", "MODE", "BATCH", "JOBS", "COMMITS", "SECONDS", "JOBS/S");
+    for (size_t m = 0; m < sizeof(MODES) / sizeof(MODES[0]); m++) {
+        size_t jobs = MODES[m].limit ? min(submissions, MODES[m].limit) : submissions;
+
+        unlink(JOURNAL_PATH);
+        Scheduler *s = scheduler_create(MODES[m].journal);
+        if (!s) {
+            return EXIT_FAILURE;
+        }
+
+        Time   start   = timestamp();
+        for (size_t i = 0; i < jobs; i++) {
+            snprintf(command, BUFSIZ, "./worksim %lu", i % 1000);
+            if (!scheduler_add(s, NULL, command)) {
+                status = EXIT_FAILURE;
+                break;
+            }
+            if (MODES[m].batch && (i + 1) % MODES[m].batch == 0) {
+                journal_commit(&s->journal);
+            }
+        }
+        journal_commit(&s->journal);
+        double elapsed = time_to_seconds(timestamp() - start);
+
+        printf("%-6s %6lu %8lu %8lu %10.3lf %12.1lf\n", MODES[m].name, MODES[m].batch, jobs,
+            s->journal.commits, elapsed, jobs / elapsed);
+        if (MODES[m].batch > 1 && jobs / elapsed < TARGET) {
+            status = EXIT_FAILURE;
+        }
+        scheduler_delete(s);
+    }
+
+    /* Replay (and compact) the journal from the last grouped run */
+    unlink(JOURNAL_PATH);
+    Scheduler *s = scheduler_create(true);
+    if (!s) {
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < submissions; i++) {
+        snprintf(command, BUFSIZ, "./worksim %lu", i % 1000);
+        scheduler_add(s, NULL, command);
+    }
+    scheduler_delete(s);
+
+    Time   start   = timestamp();
+    s = scheduler_create(true);
+    double elapsed = time_to_seconds(timestamp() - start);
+    if (!s) {
+        return EXIT_FAILURE;
+    }
+    printf("%-6s %6s %8lu %8s %10.3lf %12.1lf\n", "replay", "-", scheduler_waiting(s), "-", elapsed,
+        scheduler_waiting(s) / elapsed);
+    scheduler_delete(s);
+
+    unlink(JOURNAL_PATH);
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
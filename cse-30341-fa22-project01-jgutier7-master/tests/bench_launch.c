@@ -0,0 +1,68 @@
+/* bench_launch.c: Benchmark PQSH Process Launch */
+
+#include "pqsh/macros.h"
+#include "pqsh/process.h"
+#include "pqsh/timestamp.h"
+
+#include <string.h>
+#include <sys/wait.h>
+
+/* Constants */
+
+const char *COMMAND = "true";
+
+const struct {
+    const char *name;
+    LaunchMode  mode;
+} MODES[] = {
+    { "fork",  LAUNCH_FORK },
+    { "vfork", LAUNCH_VFORK },
+    { "spawn", LAUNCH_SPAWN },
+};
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    size_t launches = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+    size_t rss      = argc > 2 ? strtoul(argv[2], NULL, 10) : 256;
+
+    if (argc > 3 || !launches) {
+        fprintf(stderr, "Usage: %s [LAUNCHES] [RSS_MB]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* Inflate resident set so fork has page tables to copy */
+    char *ballast = malloc(rss << 20);
+    if (rss && !ballast) {
+        fprintf(stderr, "Unable to allocate %lu MB\n", rss);
+        return EXIT_FAILURE;
+    }
+    memset(ballast, 1, rss << 20);
+
+    printf("%-6s %8s %8s %10s %12s\n", "MODE", "RSS_MB", "LAUNCHES", "SECONDS", "LAUNCHES/S");
+    for (size_t m = 0; m < sizeof(MODES) / sizeof(MODES[0]); m++) {
+        Process *p = process_create(COMMAND);
+        if (!p) {
+            return EXIT_FAILURE;
+        }
+
+        Time   start   = timestamp();
+        for (size_t i = 0; i < launches; i++) {
+            p->pid = 0;
+            if (!process_launch(p, MODES[m].mode)) {
+                process_delete(p);
+                return EXIT_FAILURE;
+            }
+            waitpid(p->pid, NULL, 0);
+        }
+        double elapsed = time_to_seconds(timestamp() - start);
+
+        printf("%-6s %8lu %8lu %10.3lf %12.1lf\n", MODES[m].name, rss, launches, elapsed, launches / elapsed);
+        process_delete(p);
+    }
+
+    free(ballast);
+    return EXIT_SUCCESS;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,194 @@
+/* bench_scheduler.c: Benchmark PQSH Scheduling Policies */
+
+#include "pqsh/macros.h"
+#include "pqsh/scheduler.h"
+#include "pqsh/simulator.h"
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+/* Constants */
+
+#define MEAN_BURST  0.1             /* Mean CPU time of a job (seconds) */
+#define MAX_BURST   100.0           /* Heavy tail cutoff (seconds) */
+#define IO_COUNT    10              /* I/O operations per job in io workload */
+#define IO_TIME     0.02            /* Duration of each I/O operation (seconds) */
+#define TIMEOUT     10000           /* Time slice (microseconds) */
+#define SEED        0x9E3779B97F4A7C15ULL
+
+typedef enum {
+    WORKLOAD_CPU,                   /* Poisson arrivals, exponential bursts */
+    WORKLOAD_IO,                    /* Poisson arrivals, short CPU phases between I/O */
+    WORKLOAD_BURSTY,                /* Groups of simultaneous arrivals */
+    WORKLOAD_HEAVYTAIL,             /* Poisson arrivals, Pareto bursts */
+} Workload;
+
+const char *WORKLOADS[] = { "cpu", "io", "bursty", "heavytail" };
+
+const struct {
+    const char *name;
+    Policy      policy;
+    double      overhead;           /* Adaptive time slice target (0 == fixed) */
+    bool        swap;               /* Swap sleeping processes out of cores */
+} POLICIES[] = {
+    { "fifo", FIFO_POLICY,     0,    false },
+    { "rdrn", RDRN_POLICY,     0,    false },
+    { "auto", RDRN_POLICY,     0.02, false },
+    { "swap", RDRN_POLICY,     0,    true },
+    { "mlfq", MLFQ_POLICY,     0,    false },
+    { "cfs",  CFS_POLICY,      0,    false },
+    { "srtf", SRTF_POLICY,     0,    false },
+    { "lott", LOTTERY_POLICY,  0,    false },
+    { "strd", STRIDE_POLICY,   0,    false },
+};
+
+const size_t CORES[] = { 1, 2, 4 };
+
+/* Random Numbers (xorshift64*, so workloads are identical across runs and machines) */
+
+static uint64_t RandomState = SEED;
+
+double uniform() {
+    RandomState ^= RandomState >> 12;
+    RandomState ^= RandomState << 25;
+    RandomState ^= RandomState >> 27;
+    return (((RandomState * 0x2545F4914F6CDD1DULL) >> 11) + 1) * 0x1.0p-53;     // (0, 1]
+}
+
+double exponential(double mean) {
+    return -mean * log(uniform());
+}
+
+double pareto(double mean, double alpha) {
+    double scale = mean * (alpha - 1) / alpha;
+    return min(scale * pow(uniform(), -1 / alpha), MAX_BURST);
+}
+
+/* Workload Generation */
+
+/**
+ * Write synthetic trace in simulator format.
+ * @param   fs          Output file stream.
+ * @param   workload    Job mix to generate.
+ * @param   jobs        Number of jobs.
+ * @param   rate        Mean arrival rate (jobs per second).
+ **/
+void generate(FILE *fs, Workload workload, size_t jobs, double rate) {
+    double arrival = 0;
+
+    RandomState = SEED;
+    for (size_t i = 0; i < jobs; ) {
+        size_t group = 1;
+        if (workload == WORKLOAD_BURSTY) {                          // geometric group size, mean 10
+            while (uniform() > 0.1) group++;
+        }
+        arrival += exponential(group / rate);
+
+        for (; group && i < jobs; group--, i++) {
+            double burst = workload == WORKLOAD_HEAVYTAIL ? pareto(MEAN_BURST, 1.5) : exponential(MEAN_BURST);
+            int    size  = burst < MEAN_BURST / 4 ? 0 : (burst < MEAN_BURST * 4 ? 1 : 2);
+
+            if (workload == WORKLOAD_IO) {
+                fprintf(fs, "%.6lf %.6lf %.6lf %.6lf %s-%d\n", arrival, burst, burst / IO_COUNT, IO_TIME, WORKLOADS[workload], size);
+            } else {
+                fprintf(fs, "%.6lf %.6lf 0 0 %s-%d\n", arrival, burst, WORKLOADS[workload], size);
+            }
+        }
+    }
+}
+
+/* Measurement */
+
+double cputime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+/**
+ * Simulate trace under policy and print one row of results.
+ * @return  Whether or not every job finished.
+ **/
+bool run(const char *trace, size_t length, const char *workload, size_t p, size_t cores, double rate) {
+    Scheduler s   = {
+        .policy        = POLICIES[p].policy,
+        .overhead      = POLICIES[p].overhead,
+        .swap_sleeping = POLICIES[p].swap,
+        .cores         = cores,
+        .timeout       = TIMEOUT,
+        .launch        = LAUNCH_SIMULATE,
+        .levels        = 3,
+        .boost         = 1000000,
+    };
+    Simulator sim = {0};
+    bool      done = false;
+
+    FILE *fs = fmemopen((void *)trace, length, "r");
+    if (!fs || !scheduler_init(&s) || !simulator_load(&sim, fs)) {
+        goto cleanup;
+    }
+
+    double start = cputime();
+    done         = simulator_run(&sim, &s);
+    double spent = cputime() - start;
+
+    printf("%-9s %-4s %5lu %7.1lf %7lu %10.2lf %9.3lf %9.3lf %9.3lf %9.3lf %9.3lf %9.3lf\n",
+        workload, POLICIES[p].name, cores, rate, sim.finished,
+        sim.now > 0 ? sim.finished / sim.now : 0.0,
+        sim.finished ? spent * 1000000.0 / sim.finished : 0.0,
+        time_to_seconds(histogram_percentile(&s.turnaround, 50)), time_to_seconds(histogram_percentile(&s.turnaround, 99)),
+        time_to_seconds(histogram_percentile(&s.response, 50)), time_to_seconds(histogram_percentile(&s.response, 99)),
+        time_to_seconds(histogram_mean(&s.wait)));
+
+cleanup:
+    if (fs) fclose(fs);
+    scheduler_release(&s);
+    simulator_release(&sim);
+    return done;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    size_t jobs = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+    double load = argc > 2 ? strtod(argv[2], NULL) : 0.8;
+    int status  = EXIT_SUCCESS;
+
+    if (argc > 3 || !jobs || load <= 0) {
+        fprintf(stderr, "Usage: %s [JOBS] [LOAD]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* Throughput and latency are in simulated seconds (deterministic); CPU_US is real scheduler cost per job */
+    printf("%-9s %-4s %5s %7s %7s %10s %9s %9s %9s %9s %9s %9s\n",
+        "WORKLOAD", "POLICY", "CORES", "RATE", "JOBS", "JOBS/S", "CPU_US",
+        "TURN_P50", "TURN_P99", "RESP_P50", "RESP_P99", "WAIT_AVG");
+
+    for (size_t w = 0; w < sizeof(WORKLOADS) / sizeof(WORKLOADS[0]); w++) {
+        for (size_t c = 0; c < sizeof(CORES) / sizeof(CORES[0]); c++) {
+            double hold   = MEAN_BURST + (w == WORKLOAD_IO ? IO_COUNT * IO_TIME : 0);
+            double rate   = load * CORES[c] / hold;                 // blocked jobs still hold their core
+            char  *trace  = NULL;
+            size_t length = 0;
+
+            FILE *fs = open_memstream(&trace, &length);
+            if (!fs) {
+                return EXIT_FAILURE;
+            }
+            generate(fs, w, jobs, rate);
+            fclose(fs);
+
+            for (size_t p = 0; p < sizeof(POLICIES) / sizeof(POLICIES[0]); p++) {
+                if (!run(trace, length, WORKLOADS[w], p, CORES[c], rate)) {
+                    status = EXIT_FAILURE;
+                }
+            }
+            free(trace);
+        }
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,55 @@
+/* bench_timestamp.c: Benchmark PQSH Timestamp */
+
+#include "pqsh/macros.h"
+#include "pqsh/timestamp.h"
+
+#include <sys/time.h>
+
+/* Functions */
+
+/* Previous clock: wall time in seconds as a double */
+double gettimeofday_seconds() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    size_t calls = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+
+    if (argc > 2 || !calls) {
+        fprintf(stderr, "Usage: %s [CALLS]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%-12s %10s %10s\n", "CLOCK", "CALLS", "NS/CALL");
+
+    volatile double seconds = 0;
+    Time start = timestamp();
+    for (size_t i = 0; i < calls; i++) {
+        seconds += gettimeofday_seconds();
+    }
+    printf("%-12s %10lu %10.1lf\n", "gettimeofday", calls, (double)(timestamp() - start) / calls);
+
+    volatile Time sink = 0;
+    start = timestamp();
+    for (size_t i = 0; i < calls; i++) {
+        sink += timestamp();
+    }
+    printf("%-12s %10lu %10.1lf\n", "monotonic", calls, (double)(timestamp() - start) / calls);
+
+    if (!timestamp_tsc()) {
+        printf("%-12s %10s %10s\n", "tsc", "-", "-");
+        return EXIT_SUCCESS;
+    }
+    start = timestamp();
+    for (size_t i = 0; i < calls; i++) {
+        sink += timestamp();
+    }
+    printf("%-12s %10lu %10.1lf\n", "tsc", calls, (double)(timestamp() - start) / calls);
+    return EXIT_SUCCESS;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,195 @@
+/* unit_capture.c: Test PQSH Job Output Capture */
+
+#include "pqsh/macros.h"
+#include "pqsh/capture.h"
+#include "pqsh/scheduler.h"
+
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Constants */
+
+#define CAPTURE_DIRECTORY   "unit_capture.d"
+
+const char OUTPUT[] = "0123456789abcdefghij";
+
+/* Functions */
+
+/* Write text into pipe as the process would, then read until end of file */
+Output *capture_fill(Capture *c, const char *text) {
+    Output *o = capture_open(c);
+    assert(o);
+    assert(write(o->sink, text, strlen(text)) == (ssize_t)strlen(text));
+    assert(capture_start(c, o, getpid()));
+    while (o->fd >= 0) {
+        capture_read(c, o, 8);
+    }
+    return o;
+}
+
+/* Return captured output of process as string (caller frees) */
+char *capture_text(Capture *c, Output *o) {
+    char  *text = NULL;
+    size_t size = 0;
+    FILE  *fs   = open_memstream(&text, &size);
+    assert(fs);
+    capture_dump(c, o, fs);
+    fclose(fs);
+    return text;
+}
+
+/* Test cases */
+
+int test_00_capture_ring() {
+    Capture c = { .size = 16 };
+    assert(capture_init(&c));
+
+    /* Only the most recent bytes are kept */
+    Output *o = capture_fill(&c, OUTPUT);
+    assert(o->bytes == strlen(OUTPUT) && c.bytes == strlen(OUTPUT));
+    char *text = capture_text(&c, o);
+    assert(streq(text, OUTPUT + strlen(OUTPUT) - 16));
+    free(text);
+    capture_close(o);
+
+    /* Output that fits is kept whole */
+    o    = capture_fill(&c, "hello\n");
+    text = capture_text(&c, o);
+    assert(streq(text, "hello\n"));
+    free(text);
+    capture_close(o);
+
+    capture_release(&c);
+    return EXIT_SUCCESS;
+}
+
+int test_01_capture_log() {
+    Capture c = { .directory = CAPTURE_DIRECTORY, .size = 16 };
+    char    path[BUFSIZ];
+    char    buffer[BUFSIZ] = {0};
+
+    assert(capture_init(&c));
+    Output *o = capture_fill(&c, OUTPUT);
+    assert(o->bytes == strlen(OUTPUT) && !o->ring);
+
+    /* Log is named after pid and start time, has everything, status shows its tail */
+    snprintf(path, BUFSIZ, "%s/%d-", CAPTURE_DIRECTORY, getpid());
+    assert(o->path && strncmp(o->path, path, strlen(path)) == 0);
+    strcpy(path, o->path);
+    FILE *fs = fopen(path, "r");
+    assert(fs);
+    assert(fread(buffer, 1, BUFSIZ, fs) == strlen(OUTPUT));
+    fclose(fs);
+    assert(streq(buffer, OUTPUT));
+
+    char *text = capture_text(&c, o);
+    assert(streq(text, OUTPUT + strlen(OUTPUT) - 16));
+    free(text);
+
+    capture_close(o);
+    capture_release(&c);
+    unlink(path);
+    rmdir(CAPTURE_DIRECTORY);
+    return EXIT_SUCCESS;
+}
+
+int test_02_scheduler_output() {
+    Scheduler s = { .policy = FIFO_POLICY, .cores = 2, .timeout = 250000, .launch = LAUNCH_SPAWN, .capture.size = CAPTURE_RING };
+    assert(scheduler_init(&s));
+    assert(s.capture.fd >= 0);
+
+    /* More output than a pipe holds: jobs block until drained */
+    Process *p = scheduler_add(&s, NULL, "seq 1 100000");
+    Process *q = scheduler_add(&s, NULL, "sh -c 'echo failed >&2; exit 1'");
+    assert(p && q);
+    scheduler_next(&s);
+    while (s.running.size) {
+        capture_drain(&s.capture);
+        scheduler_wait(&s);
+        usleep(1000);
+    }
+    assert(p->output->bytes == 588895 && q->output->bytes == 7);
+
+    char  *text = NULL;
+    size_t size = 0;
+    FILE  *fs   = open_memstream(&text, &size);
+    assert(fs);
+    assert(scheduler_output(&s, fs, p->pid));
+    assert(scheduler_output(&s, fs, q->pid));
+    assert(!scheduler_output(&s, fs, 0));
+    fclose(fs);
+    assert(strstr(text, "Output (588895 bytes):\n"));
+    assert(strstr(text, "99999\n100000\n"));
+    assert(strstr(text, "Output (7 bytes):\nfailed\n"));
+    free(text);
+
+    scheduler_release(&s);
+    return EXIT_SUCCESS;
+}
+
+int test_03_capture_reuse() {
+    Scheduler s = { .policy = FIFO_POLICY, .cores = 1, .timeout = 250000, .launch = LAUNCH_SPAWN, .capture.directory = CAPTURE_DIRECTORY };
+    assert(scheduler_init(&s));
+
+    /* Two jobs with the same pid keep separate logs */
+    Process *p = process_create("first");
+    Process *q = process_create("second");
+    assert(p && q);
+    p->output = capture_fill(&s.capture, "first\n");
+    q->output = capture_fill(&s.capture, "second\n");
+    assert(p->output->path && q->output->path && !streq(p->output->path, q->output->path));
+    p->pid = q->pid = getpid();
+    queue_push(&s.finished, p);
+    queue_push(&s.finished, q);
+
+    char  *text = NULL;
+    size_t size = 0;
+    FILE  *fs   = open_memstream(&text, &size);
+    assert(fs);
+    assert(scheduler_output(&s, fs, getpid()));
+    fclose(fs);
+    assert(strstr(text, q->output->path) && strstr(text, "Output (7 bytes):\nsecond\n"));
+    free(text);
+
+    text = capture_text(&s.capture, p->output);
+    assert(streq(text, "first\n"));
+    free(text);
+
+    unlink(p->output->path);
+    unlink(q->output->path);
+    scheduler_release(&s);
+    rmdir(CAPTURE_DIRECTORY);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test capture_ring\n");
+	fprintf(stderr, "    1. Test capture_log\n");
+	fprintf(stderr, "    2. Test scheduler_output\n");
+	fprintf(stderr, "    3. Test capture_reuse\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_capture_ring(); break;
+	case 1:	status = test_01_capture_log(); break;
+	case 2:	status = test_02_scheduler_output(); break;
+	case 3:	status = test_03_capture_reuse(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,90 @@
+/* unit_control.c: Test PQSH Control Socket */
+
+#define _GNU_SOURCE
+
+#include "pqsh/macros.h"
+#include "pqsh/control.h"
+
+#include <assert.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+/* Constants */
+
+#define PATH    "/tmp/unit_control.sock"
+
+/* Test cases */
+
+int test_00_control_open() {
+    unlink(PATH);
+    assert(control_connect(PATH) < 0);
+
+    int server = control_open(PATH);
+    assert(server >= 0);
+
+    struct stat st;
+    assert(stat(PATH, &st) == 0 && S_ISSOCK(st.st_mode));
+
+    /* Non-blocking accept */
+    assert(accept4(server, NULL, NULL, SOCK_CLOEXEC) < 0);
+
+    /* A live socket is not stolen (the probe leaves a closed connection) */
+    assert(control_open(PATH) < 0);
+    int probe = accept4(server, NULL, NULL, SOCK_CLOEXEC);
+    assert(probe >= 0);
+    close(probe);
+
+    int client = control_connect(PATH);
+    assert(client >= 0);
+    int accepted = accept4(server, NULL, NULL, SOCK_CLOEXEC);
+    assert(accepted >= 0);
+
+    assert(write(client, "status\n", 7) == 7);
+    char buffer[BUFSIZ] = {0};
+    assert(read(accepted, buffer, BUFSIZ) == 7);
+    assert(streq(buffer, "status\n"));
+
+    close(accepted);
+    close(client);
+    close(server);
+
+    /* A stale socket is replaced */
+    server = control_open(PATH);
+    assert(server >= 0);
+    close(server);
+    unlink(PATH);
+
+    /* Paths that do not fit are rejected */
+    char path[BUFSIZ];
+    memset(path, 'x', sizeof(path) - 1);
+    path[sizeof(path) - 1] = 0;
+    assert(control_open(path) < 0);
+    assert(control_connect(path) < 0);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test control_open\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_control_open(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,148 @@
+/* unit_dag.c: Test PQSH Job Dependency Graph */
+
+#include "pqsh/macros.h"
+#include "pqsh/scheduler.h"
+
+#include <assert.h>
+#include <sys/wait.h>
+
+/* Functions */
+
+/* Single core FIFO scheduler with simulated launches */
+Scheduler *scheduler_create() {
+    Scheduler *s = calloc(1, sizeof(Scheduler));
+    assert(s);
+
+    s->policy  = FIFO_POLICY;
+    s->cores   = 1;
+    s->timeout = 250000;
+    s->launch  = LAUNCH_SIMULATE;
+    assert(scheduler_init(s));
+    return s;
+}
+
+void scheduler_delete(Scheduler *s) {
+    scheduler_release(s);
+    free(s);
+}
+
+/* Test cases */
+
+int test_00_dag_add() {
+    Dag d = {0};
+
+    /* fetch -> build -> test, fetch -> docs */
+    DagNode *fetch = dag_add(&d, NULL, "fetch", NULL, 0, 1);
+    DagNode *build = dag_add(&d, NULL, "build", &fetch, 1, 5);
+    DagNode *docs  = dag_add(&d, NULL, "docs", &fetch, 1, 2);
+    DagNode *test  = dag_add(&d, NULL, NULL, &build, 1, 3);
+    assert(fetch && build && docs && test);
+
+    assert(dag_find(&d, "fetch") == fetch);
+    assert(dag_find(&d, "docs") == docs);
+    assert(dag_find(&d, "test") == NULL);
+    assert(d.size == 3);
+
+    /* Critical path: fetch (1) + build (5) + test (3) */
+    assert(test->rank == 3);
+    assert(build->rank == 8);
+    assert(docs->rank == 2);
+    assert(fetch->rank == 9);
+
+    assert(fetch->ndependents == 2 && fetch->pending == 0);
+    assert(build->pending == 1 && test->nafter == 1);
+
+    /* Finished jobs are not waited on */
+    fetch->finished = true;
+    DagNode *late = dag_add(&d, NULL, "late", &fetch, 1, 1);
+    assert(late && late->pending == 0);
+
+    /* Many named nodes */
+    char id[BUFSIZ];
+    for (size_t i = 0; i < 1000; i++) {
+        snprintf(id, BUFSIZ, "job%lu", i);
+        assert(dag_add(&d, NULL, id, &late, 1, 1));
+    }
+    assert(d.size == 1004);
+    assert(dag_find(&d, "job999") && dag_find(&d, "job0"));
+    assert(late->ndependents == 1000 && late->rank == 2);
+
+    dag_release(&d);
+    return EXIT_SUCCESS;
+}
+
+int test_01_scheduler_add() {
+    Scheduler *s = scheduler_create();
+
+    assert(scheduler_add(s, NULL, "--id fetch fetch"));
+    assert(scheduler_add(s, NULL, "--id small --after fetch small"));
+    assert(scheduler_add(s, NULL, "--id build --after fetch build"));
+    assert(scheduler_add(s, NULL, "--id test --after build test"));
+    assert(scheduler_add(s, NULL, "--after small,test report"));
+    assert(scheduler_add(s, NULL, "plain"));
+
+    /* Invalid references are rejected */
+    assert(!scheduler_add(s, NULL, "--id fetch again"));
+    assert(!scheduler_add(s, NULL, "--after nothing job"));
+    assert(!scheduler_add(s, NULL, "--after fetch,nothing job"));
+
+    assert(s->waiting.size == 2 && s->blocked.size == 4);
+    assert(scheduler_waiting(s) == 6);
+
+    /* Critical path first: fetch before plain */
+    assert(streq(s->waiting.head->command, "fetch"));
+    scheduler_next(s);
+    Process *fetch = s->running.head;
+    assert(streq(fetch->command, "fetch"));
+
+    /* Dependents are released in critical path order (build before small) */
+    scheduler_exit(s, fetch, 0, NULL);
+    assert(s->blocked.size == 2);
+    assert(streq(s->waiting.head->command, "build"));
+    assert(streq(s->waiting.head->next->command, "small"));
+    assert(streq(s->waiting.tail->command, "plain"));
+
+    /* Failure cancels everything downstream */
+    scheduler_next(s);
+    Process *build = s->running.head;
+    assert(streq(build->command, "build"));
+    scheduler_exit(s, build, W_EXITCODE(1, 0), NULL);
+    assert(s->blocked.size == 0);
+    assert(s->finished.size == 4);
+    assert(WEXITSTATUS(s->finished.tail->status) == DAG_CANCELLED);
+    assert(streq(s->finished.tail->command, "report"));
+
+    /* Jobs after a failed job are cancelled immediately */
+    assert(scheduler_add(s, NULL, "--after test later"));
+    assert(s->finished.size == 5);
+
+    scheduler_delete(s);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test dag_add\n");
+	fprintf(stderr, "    1. Test scheduler_add\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_dag_add(); break;
+	case 1:	status = test_01_scheduler_add(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,144 @@
+/* unit_histogram.c: Test PQSH Latency Histogram */
+
+#include "pqsh/macros.h"
+#include "pqsh/histogram.h"
+
+#include <assert.h>
+
+/* Constants */
+
+#define NVALUES     10000
+
+/* Functions */
+
+/* Whether or not actual is within the histogram's relative error of expected */
+int close_to(Time actual, Time expected) {
+    Time error = actual - expected;
+    if (error < 0) error = -error;
+    return error <= expected / HISTOGRAM_HALF + 1;
+}
+
+/* Test cases */
+
+int test_00_histogram_record() {
+    Histogram *h = calloc(1, sizeof(Histogram));
+    assert(h);
+
+    assert(histogram_percentile(h, 50) == 0);
+    assert(histogram_mean(h) == 0);
+
+    const Time year = 3600 * 24 * 365 * NSEC_PER_SEC;
+
+    histogram_record(h, 50 * NSEC_PER_USEC);
+    histogram_record(h, time_from_seconds(1.5));
+    histogram_record(h, -1);
+    histogram_record(h, year);
+
+    assert(h->count == 4);
+    assert(h->max == year);
+    assert(h->sum == year + time_from_seconds(1.50005));
+    assert(histogram_percentile(h, 0) == 0);
+    assert(close_to(histogram_percentile(h, 50), 50 * NSEC_PER_USEC));
+    assert(close_to(histogram_percentile(h, 75), time_from_seconds(1.5)));
+    assert(histogram_percentile(h, 100) == h->max);
+
+    /* Sub-microsecond values are distinguished */
+    Histogram *fast = calloc(1, sizeof(Histogram));
+    assert(fast);
+    for (Time value = 100; value <= 900; value += 100) {
+        histogram_record(fast, value);
+    }
+    assert(histogram_percentile(fast, 10) == 100);
+    assert(close_to(histogram_percentile(fast, 50), 500));
+    assert(histogram_mean(fast) == 500);
+    free(fast);
+
+    free(h);
+    return EXIT_SUCCESS;
+}
+
+int test_01_histogram_percentile() {
+    Histogram *h = calloc(1, sizeof(Histogram));
+    assert(h);
+
+    /* Uniform values from 1 ms to 10 s */
+    const Time ms = NSEC_PER_SEC / 1000;
+    for (size_t i = 1; i <= NVALUES; i++) {
+        histogram_record(h, i * ms);
+    }
+
+    assert(h->count == NVALUES);
+    assert(close_to(histogram_mean(h), (NVALUES + 1) * ms / 2));
+    assert(close_to(histogram_percentile(h, 50), 5 * NSEC_PER_SEC));
+    assert(close_to(histogram_percentile(h, 90), 9 * NSEC_PER_SEC));
+    assert(close_to(histogram_percentile(h, 99), time_from_seconds(9.9)));
+    assert(histogram_percentile(h, 100) == 10 * NSEC_PER_SEC);
+
+    /* Percentiles never decrease */
+    for (double p = 1; p <= 100; p++) {
+        assert(histogram_percentile(h, p) >= histogram_percentile(h, p - 1));
+    }
+
+    free(h);
+    return EXIT_SUCCESS;
+}
+
+int test_02_histogram_decay() {
+    Histogram *h = calloc(1, sizeof(Histogram));
+    assert(h);
+
+    /* Old values are slow, new values are fast */
+    for (size_t i = 0; i < 100; i++) {
+        histogram_record(h, NSEC_PER_SEC);
+    }
+    histogram_decay(h);
+    histogram_decay(h);
+    for (size_t i = 0; i < 100; i++) {
+        histogram_record(h, NSEC_PER_SEC / 1000);
+    }
+
+    assert(h->count == 125);
+    assert(close_to(h->sum, time_from_seconds(25.1)));
+    assert(close_to(histogram_percentile(h, 50), NSEC_PER_SEC / 1000));
+    assert(h->max == NSEC_PER_SEC);
+
+    /* Decaying to nothing resets summary */
+    for (size_t i = 0; i < 8; i++) {
+        histogram_decay(h);
+    }
+    assert(h->count == 0);
+    assert(h->sum == 0 && h->max == 0);
+    assert(histogram_percentile(h, 50) == 0);
+
+    free(h);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test histogram_record\n");
+	fprintf(stderr, "    1. Test histogram_percentile\n");
+	fprintf(stderr, "    2. Test histogram_decay\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_histogram_record(); break;
+	case 1:	status = test_01_histogram_percentile(); break;
+	case 2:	status = test_02_histogram_decay(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,111 @@
+/* unit_history.c: Test PQSH Runtime History */
+
+#include "pqsh/macros.h"
+#include "pqsh/history.h"
+
+#include <assert.h>
+#include <unistd.h>
+
+/* Constants */
+
+#define HISTORY_PATH    "unit_history.txt"
+#define NCOMMANDS       1000
+
+/* Functions */
+
+/* Whether or not values are equal within rounding */
+int equal(double a, double b) {
+    return a - b < 1e-6 && b - a < 1e-6;
+}
+
+/* Test cases */
+
+int test_00_history_update() {
+    History h = {0};
+
+    /* Nothing learned yet */
+    assert(equal(history_estimate(&h, "sleep 1"), 0));
+
+    /* First observation is taken as is, later ones are weighted by HISTORY_ALPHA */
+    assert(history_update(&h, "sleep 1", 2));
+    assert(equal(history_estimate(&h, "sleep 1"), 2));
+    assert(history_update(&h, "sleep 1", 4));
+    assert(equal(history_estimate(&h, "sleep 1"), HISTORY_ALPHA * 4 + (1 - HISTORY_ALPHA) * 2));
+
+    /* Unknown commands get the mean of all estimates */
+    assert(history_update(&h, "sleep 2", 1));
+    assert(equal(history_estimate(&h, "true"), (history_estimate(&h, "sleep 1") + 1) / 2));
+
+    /* Entries survive growing the table */
+    char command[BUFSIZ];
+    for (size_t i = 0; i < NCOMMANDS; i++) {
+        snprintf(command, BUFSIZ, "job %lu", i);
+        assert(history_update(&h, command, i));
+    }
+    assert(h.size == NCOMMANDS + 2 && h.capacity > HISTORY_BUCKETS);
+    for (size_t i = 0; i < NCOMMANDS; i++) {
+        snprintf(command, BUFSIZ, "job %lu", i);
+        assert(equal(history_estimate(&h, command), i));
+    }
+
+    history_release(&h);
+    return EXIT_SUCCESS;
+}
+
+int test_01_history_save() {
+    History h = {0};
+    History g = {0};
+
+    /* Missing file is an empty history */
+    unlink(HISTORY_PATH);
+    assert(history_load(&g, HISTORY_PATH));
+    assert(g.size == 0);
+
+    assert(history_update(&h, "sleep 1", 1.5));
+    assert(history_update(&h, "sleep 1", 0.5));
+    assert(history_update(&h, "sh -c 'echo a b'", 3));
+    assert(history_save(&h, HISTORY_PATH));
+
+    /* Estimates and commands with spaces round-trip */
+    assert(history_load(&g, HISTORY_PATH));
+    assert(g.size == 2);
+    assert(equal(history_estimate(&g, "sleep 1"), history_estimate(&h, "sleep 1")));
+    assert(equal(history_estimate(&g, "sh -c 'echo a b'"), 3));
+    assert(equal(g.total, h.total));
+
+    /* Loading again replaces entries instead of duplicating them */
+    assert(history_load(&g, HISTORY_PATH));
+    assert(g.size == 2 && equal(g.total, h.total));
+
+    history_release(&h);
+    history_release(&g);
+    unlink(HISTORY_PATH);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test history_update\n");
+	fprintf(stderr, "    1. Test history_save\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_history_update(); break;
+	case 1:	status = test_01_history_save(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
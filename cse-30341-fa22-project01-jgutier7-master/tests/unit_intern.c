@@ -0,0 +1,82 @@
+/* unit_intern.c: Test PQSH Interned Strings */
+
+#include "pqsh/macros.h"
+#include "pqsh/intern.h"
+#include "pqsh/process.h"
+
+#include <assert.h>
+
+/* Test cases */
+
+int test_00_intern_acquire() {
+    char buffer[BUFSIZ];
+
+    const char *a = intern_acquire("sleep 1");
+    strcpy(buffer, "sleep 1");
+    const char *b = intern_acquire(buffer);
+    const char *c = intern_acquire("sleep 2");
+
+    assert(a && b && c);
+    assert(a == b);
+    assert(a != c);
+    assert(streq(a, "sleep 1"));
+    assert(intern_count() == 2);
+    assert(intern_entry(a)->refs == 2);
+
+    intern_release(a);
+    assert(intern_count() == 2);
+    intern_release(b);
+    intern_release(c);
+    assert(intern_count() == 0);
+
+    return EXIT_SUCCESS;
+}
+
+int test_01_intern_process() {
+    Process *p = process_create("sleep 10");
+    Process *q = process_create("sleep 10");
+    Process *r = process_create("sleep 20");
+
+    assert(p && q && r);
+    assert(p->command == q->command);
+    assert(p->argv == q->argv);
+    assert(p->argv != r->argv);
+    assert(process_count() == 3);
+    assert(intern_count() == 2);
+
+    process_delete(p);
+    assert(streq(q->argv[1], "10"));
+    process_delete(q);
+    process_delete(r);
+    assert(process_count() == 0);
+    assert(intern_count() == 0);
+
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test intern_acquire\n");
+	fprintf(stderr, "    1. Test intern_process\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_intern_acquire(); break;
+	case 1:	status = test_01_intern_process(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
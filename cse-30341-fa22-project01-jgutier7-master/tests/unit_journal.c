@@ -0,0 +1,242 @@
+/* unit_journal.c: Test PQSH Write-Ahead Journal */
+
+#include "pqsh/macros.h"
+#include "pqsh/scheduler.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* Constants */
+
+#define JOURNAL_PATH    "unit_journal.log"
+
+/* Functions */
+
+/* Single core FIFO scheduler with simulated launches, recovered from journal */
+Scheduler *scheduler_create() {
+    Scheduler *s = calloc(1, sizeof(Scheduler));
+    assert(s);
+
+    s->policy       = FIFO_POLICY;
+    s->cores        = 1;
+    s->timeout      = 250000;
+    s->launch       = LAUNCH_SIMULATE;
+    s->journal_path = JOURNAL_PATH;
+    assert(scheduler_init(s));
+    assert(scheduler_recover(s));
+    return s;
+}
+
+void scheduler_delete(Scheduler *s) {
+    scheduler_release(s);
+    free(s);
+}
+
+/* Append raw text to journal */
+void journal_write_raw(const char *text) {
+    FILE *fs = fopen(JOURNAL_PATH, "a");
+    assert(fs);
+    fputs(text, fs);
+    fclose(fs);
+}
+
+/* Test cases */
+
+int test_00_journal_append() {
+    Journal j = {0};
+
+    unlink(JOURNAL_PATH);
+    assert(journal_open(&j, JOURNAL_PATH, true));
+
+    /* Appends are buffered until commit */
+    for (size_t i = 0; i < 100; i++) {
+        assert(journal_append(&j, "record %lu\n", i));
+    }
+    assert(j.size > 0 && j.commits == 0);
+    assert(journal_commit(&j));
+    assert(j.size == 0 && j.commits == 1);
+
+    /* Committing nothing does not sync */
+    assert(journal_commit(&j));
+    assert(j.commits == 1);
+
+    /* Records larger than the buffer spill without waiting for a commit */
+    char record[BUFSIZ];
+    memset(record, 'x', BUFSIZ - 2);
+    record[BUFSIZ - 2] = 0;
+    for (size_t i = 0; i < 2 * JOURNAL_BUFFER / BUFSIZ; i++) {
+        assert(journal_append(&j, "%s\n", record));
+    }
+    assert(j.size < JOURNAL_BUFFER && j.dirty);
+    journal_close(&j);
+
+    FILE *fs = fopen(JOURNAL_PATH, "r");
+    assert(fs);
+    char   line[BUFSIZ];
+    size_t lines = 0;
+    while (fgets(line, BUFSIZ, fs)) {
+        lines++;
+    }
+    fclose(fs);
+    assert(lines == 100 + 2 * JOURNAL_BUFFER / BUFSIZ);
+
+    unlink(JOURNAL_PATH);
+    return EXIT_SUCCESS;
+}
+
+int test_01_scheduler_recover() {
+    unlink(JOURNAL_PATH);
+
+    /* Run and crash (exit without release) in a child, then recover */
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        Scheduler *s = scheduler_create();
+        assert(scheduler_add(s, NULL, "first"));
+        assert(scheduler_add(s, NULL, "-w 2 -t 300 --tenant ops second"));
+        assert(scheduler_add(s, NULL, "--deadline 60 third"));
+        scheduler_next(s);
+        scheduler_exit(s, s->running.head, W_EXITCODE(3, 0), NULL);
+        scheduler_next(s);
+        assert(journal_commit(&s->journal));
+        assert(scheduler_add(s, NULL, "uncommitted"));
+        _exit(EXIT_SUCCESS);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    Scheduler *s = scheduler_create();
+    assert(s->finished.size == 1 && s->waiting.size == 2);
+    assert(streq(s->finished.head->command, "first"));
+    assert(WEXITSTATUS(s->finished.head->status) == 3);
+    assert(streq(s->waiting.head->command, "second"));          // running when it crashed
+    assert(s->waiting.head->weight == 2 && s->waiting.head->tickets == 300);
+    assert(streq(s->waiting.head->tenant->name, "ops"));
+    assert(streq(s->waiting.tail->command, "third"));
+    assert(llabs(s->waiting.tail->deadline - s->waiting.tail->arrival_time - 60 * NSEC_PER_SEC) < NSEC_PER_USEC);
+    scheduler_delete(s);
+
+    /* Clean shutdown keeps waiting jobs; torn record is ignored */
+    journal_write_raw("A\t9\t0.000000\t-- tor");
+    s = scheduler_create();
+    assert(s->finished.size == 1 && s->waiting.size == 2);
+    assert(scheduler_add(s, NULL, "fourth"));
+    scheduler_delete(s);
+
+    s = scheduler_create();
+    assert(s->finished.size == 1 && s->waiting.size == 3);
+    assert(streq(s->waiting.tail->command, "fourth"));
+    scheduler_delete(s);
+
+    unlink(JOURNAL_PATH);
+    return EXIT_SUCCESS;
+}
+
+int test_02_scheduler_recover_dag() {
+    unlink(JOURNAL_PATH);
+
+    Scheduler *s = scheduler_create();
+    assert(scheduler_add(s, NULL, "--id fetch fetch"));
+    assert(scheduler_add(s, NULL, "--id build --after fetch build"));
+    assert(scheduler_add(s, NULL, "--id docs --after fetch docs"));
+    assert(scheduler_add(s, NULL, "--after build,docs report"));
+    scheduler_next(s);
+    scheduler_exit(s, s->running.head, 0, NULL);
+    scheduler_delete(s);
+
+    /* Compacted twice, so records are rewritten from recovered jobs */
+    for (size_t i = 0; i < 2; i++) {
+        s = scheduler_create();
+        assert(s->finished.size == 1 && s->waiting.size == 2 && s->blocked.size == 1);
+        assert(streq(s->blocked.head->command, "report"));
+        assert(s->blocked.head->dag->nafter == 2);
+        assert(dag_find(&s->dag, "build") && dag_find(&s->dag, "fetch"));
+        scheduler_delete(s);
+    }
+
+    /* Failure after recovery still cancels dependents */
+    s = scheduler_create();
+    scheduler_next(s);
+    scheduler_exit(s, s->running.head, W_EXITCODE(1, 0), NULL);
+    assert(s->blocked.size == 0 && s->finished.size == 3);
+    scheduler_delete(s);
+
+    s = scheduler_create();
+    assert(s->finished.size == 3 && s->waiting.size == 1 && s->blocked.size == 0);
+    assert(WEXITSTATUS(s->finished.tail->status) == DAG_CANCELLED);
+    scheduler_delete(s);
+
+    unlink(JOURNAL_PATH);
+    return EXIT_SUCCESS;
+}
+
+int test_03_scheduler_shutdown() {
+    unlink(JOURNAL_PATH);
+
+    /* a is paused, b is running, and c never starts */
+    Scheduler *s = calloc(1, sizeof(Scheduler));
+    assert(s);
+    *s = (Scheduler) { .policy = RDRN_POLICY, .cores = 1, .timeout = 250000, .launch = LAUNCH_SPAWN, .journal_path = JOURNAL_PATH };
+    assert(scheduler_init(s) && scheduler_recover(s));
+    Process *a = scheduler_add(s, NULL, "sleep 10");
+    Process *b = scheduler_add(s, NULL, "sleep 10");
+    assert(a && b);
+    scheduler_next(s);
+    scheduler_next(s);
+    assert(s->running.head == b && a->pid && b->pid);
+    assert(scheduler_add(s, NULL, "true"));
+
+    /* Shutdown reaps launched jobs and journals their exits */
+    pid_t pids[] = { a->pid, b->pid };
+    scheduler_shutdown(s);
+    assert(!s->pids.size && !s->running.size && s->finished.size == 2);
+    for (size_t i = 0; i < 2; i++) {
+        assert(kill(pids[i], 0) < 0 && errno == ESRCH);
+    }
+    assert(WIFSIGNALED(s->finished.head->status) && WTERMSIG(s->finished.head->status) == SIGTERM);
+    scheduler_delete(s);
+
+    /* Only the job that never started is run again */
+    s = scheduler_create();
+    assert(s->finished.size == 2 && s->waiting.size == 1);
+    assert(streq(s->waiting.head->command, "true"));
+    scheduler_delete(s);
+
+    unlink(JOURNAL_PATH);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test journal_append\n");
+	fprintf(stderr, "    1. Test scheduler_recover\n");
+	fprintf(stderr, "    2. Test scheduler_recover with dependencies\n");
+	fprintf(stderr, "    3. Test scheduler_shutdown\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_journal_append(); break;
+	case 1:	status = test_01_scheduler_recover(); break;
+	case 2:	status = test_02_scheduler_recover_dag(); break;
+	case 3:	status = test_03_scheduler_shutdown(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,112 @@
+/* unit_lottery.c: Test PQSH Lottery */
+
+#include "pqsh/macros.h"
+#include "pqsh/lottery.h"
+#include "pqsh/process.h"
+
+#include <assert.h>
+
+/* Constants */
+
+#define NPROCESSES  1000
+
+Process PROCESSES[NPROCESSES];
+
+/* Functions */
+
+/* Whether every ticket is held by the process that owns its range */
+bool lottery_check(Lottery *l) {
+    size_t ticket = 0;
+    for (size_t i = 0; i < l->size; i++) {
+        Process *p = l->entries[i];
+        if (p->entry != i || lottery_draw(l, ticket) != p || lottery_draw(l, ticket + p->tickets - 1) != p) {
+            return false;
+        }
+        ticket += p->tickets;
+    }
+    return ticket == l->total && lottery_draw(l, l->total) == NULL;
+}
+
+/* Test cases */
+
+int test_00_lottery_insert() {
+    Lottery l = {0};
+
+    assert(lottery_draw(&l, 0) == NULL);
+    for (size_t i = 0; i < NPROCESSES; i++) {
+        PROCESSES[i].tickets = i + 1;
+        assert(!lottery_contains(&l, &PROCESSES[i]));
+        assert(lottery_insert(&l, &PROCESSES[i]));
+        assert(lottery_contains(&l, &PROCESSES[i]));
+    }
+    assert(l.size == NPROCESSES);
+    assert(l.total == NPROCESSES * (NPROCESSES + 1) / 2);
+    assert(lottery_check(&l));
+
+    lottery_release(&l);
+    assert(!l.size && !l.total);
+    return EXIT_SUCCESS;
+}
+
+int test_01_lottery_remove() {
+    Lottery l = {0};
+
+    for (size_t i = 0; i < NPROCESSES; i++) {
+        PROCESSES[i].tickets = i % 3 ? 100 : 300;
+        assert(lottery_insert(&l, &PROCESSES[i]));
+    }
+
+    /* Last entries move into the holes */
+    for (size_t i = 0; i < NPROCESSES; i += 2) {
+        lottery_remove(&l, &PROCESSES[i]);
+        assert(!lottery_contains(&l, &PROCESSES[i]));
+    }
+    assert(l.size == NPROCESSES / 2);
+    assert(lottery_check(&l));
+    for (size_t i = 1; i < NPROCESSES; i += 2) {
+        assert(lottery_contains(&l, &PROCESSES[i]));
+    }
+
+    /* Removed processes rejoin */
+    for (size_t i = 0; i < NPROCESSES; i += 2) {
+        assert(lottery_insert(&l, &PROCESSES[i]));
+    }
+    assert(l.size == NPROCESSES);
+    assert(lottery_check(&l));
+
+    while (l.size) {
+        lottery_remove(&l, l.entries[l.size / 2]);
+    }
+    assert(l.total == 0);
+    assert(lottery_draw(&l, 0) == NULL);
+
+    lottery_release(&l);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test lottery_insert\n");
+	fprintf(stderr, "    1. Test lottery_remove\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_lottery_insert(); break;
+	case 1:	status = test_01_lottery_remove(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,92 @@
+/* unit_pidmap.c: Test PQSH Process Identifier Index */
+
+#include "pqsh/macros.h"
+#include "pqsh/pidmap.h"
+#include "pqsh/process.h"
+
+#include <assert.h>
+
+/* Constants */
+
+#define NPROCESSES  10000
+
+Process PROCESSES[NPROCESSES];
+
+/* Test cases */
+
+int test_00_pidmap_insert() {
+    PidMap m = {0};
+
+    assert(pidmap_find(&m, 1) == NULL);
+    assert(!pidmap_insert(&m, 0, &PROCESSES[0]));
+
+    for (size_t i = 0; i < NPROCESSES; i++) {
+        PROCESSES[i].pid = 4 * i + 1;
+        assert(pidmap_insert(&m, PROCESSES[i].pid, &PROCESSES[i]));
+    }
+    assert(m.size == NPROCESSES);
+    assert(4 * m.size <= 3 * m.capacity);
+
+    for (size_t i = 0; i < NPROCESSES; i++) {
+        assert(pidmap_find(&m, PROCESSES[i].pid) == &PROCESSES[i]);
+        assert(pidmap_find(&m, PROCESSES[i].pid + 1) == NULL);
+    }
+
+    /* Replace existing entry */
+    assert(pidmap_insert(&m, PROCESSES[0].pid, &PROCESSES[1]));
+    assert(m.size == NPROCESSES);
+    assert(pidmap_find(&m, PROCESSES[0].pid) == &PROCESSES[1]);
+
+    pidmap_release(&m);
+    return EXIT_SUCCESS;
+}
+
+int test_01_pidmap_remove() {
+    PidMap m = {0};
+
+    for (size_t i = 0; i < NPROCESSES; i++) {
+        PROCESSES[i].pid = 4 * i + 1;
+        pidmap_insert(&m, PROCESSES[i].pid, &PROCESSES[i]);
+    }
+
+    for (size_t i = 0; i < NPROCESSES; i += 2) {
+        assert(pidmap_remove(&m, PROCESSES[i].pid) == &PROCESSES[i]);
+        assert(pidmap_remove(&m, PROCESSES[i].pid) == NULL);
+    }
+    assert(m.size == NPROCESSES / 2);
+
+    /* Remaining entries are still reachable after backward shifts */
+    for (size_t i = 0; i < NPROCESSES; i++) {
+        assert(pidmap_find(&m, PROCESSES[i].pid) == (i % 2 ? &PROCESSES[i] : NULL));
+    }
+
+    pidmap_release(&m);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test pidmap_insert\n");
+	fprintf(stderr, "    1. Test pidmap_remove\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_pidmap_insert(); break;
+	case 1:	status = test_01_pidmap_remove(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -16,7 +16,7 @@ int test_00_process_create() {
     assert(p);
     assert(streq(p->command, COMMAND));
     assert(p->pid == 0);
-    free(p);
+    process_delete(p);
     return EXIT_SUCCESS;
 }
 
@@ -30,7 +30,7 @@ int test_01_process_start() {
     snprintf(test, BUFSIZ, "test -n \"$(ps ux | awk '$2 == %d {print $2}')\"", p->pid);
     assert(system(test) == 0);
 
-    free(p);
+    process_delete(p);
     return EXIT_SUCCESS;
 }
 
@@ -44,7 +44,7 @@ int test_02_process_pause() {
     char test[BUFSIZ];
     snprintf(test, BUFSIZ, "test \"$(ps ux | awk '$2 == %d {print substr($8, 0, 1)}')\" = T", p->pid);
     assert(system(test) == 0);
-    free(p);
+    process_delete(p);
     return EXIT_SUCCESS;
 }
 
@@ -58,7 +58,23 @@ int test_03_process_resume() {
     char test[BUFSIZ];
     snprintf(test, BUFSIZ, "test \"$(ps ux | awk '$2 == %d {print substr($8, 0, 1)}')\" = S", p->pid);
     assert(system(test) == 0);
-    free(p);
+    process_delete(p);
+    return EXIT_SUCCESS;
+}
+
+int test_04_process_parse() {
+    char **argv = process_parse("printf  '%s %s\\n' \"a \\\"b\\\"\" c\\ d ''");
+    assert(argv);
+    assert(streq(argv[0], "printf"));
+    assert(streq(argv[1], "%s %s\\n"));
+    assert(streq(argv[2], "a \"b\""));
+    assert(streq(argv[3], "c d"));
+    assert(streq(argv[4], ""));
+    assert(argv[5] == NULL);
+    free(argv);
+
+    assert(process_parse("echo 'unterminated") == NULL);
+    assert(process_parse("   ") == NULL);
     return EXIT_SUCCESS;
 }
 
@@ -72,6 +88,7 @@ int main(int argc, char *argv[]) {
 	fprintf(stderr, "    1  Test process_start\n");
 	fprintf(stderr, "    2  Test process_pause\n");
 	fprintf(stderr, "    3  Test process_resume\n");
+	fprintf(stderr, "    4  Test process_parse\n");
 	return EXIT_FAILURE;
     }
 
@@ -83,6 +100,7 @@ int main(int argc, char *argv[]) {
 	case 1:	status = test_01_process_start(); break;
 	case 2:	status = test_02_process_pause(); break;
 	case 3:	status = test_03_process_resume(); break;
+	case 4:	status = test_04_process_parse(); break;
 	default:
 	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
 	    break;
@@ -0,0 +1,198 @@
+/* unit_procfs.c: Test PQSH /proc Readers and Admission Control */
+
+#include "pqsh/macros.h"
+#include "pqsh/procfs.h"
+#include "pqsh/scheduler.h"
+
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* Test cases */
+
+int test_00_procfs_process() {
+    size_t rss = 0;
+    char   state = 0;
+    Time   cpu_time = -1;
+
+    /* Touch memory and burn CPU so both are visible */
+    char *ballast = malloc(16 << 20);
+    assert(ballast);
+    memset(ballast, 1, 16 << 20);
+    for (volatile size_t i = 0; i < 100000000; i++);
+
+    assert(procfs_statm(getpid(), &rss));
+    assert(rss >= 16 << 20);
+    assert(procfs_stat(getpid(), &state, &cpu_time));
+    assert(state == 'R');
+    assert(cpu_time > 0);
+
+    /* Stopped and exited children */
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        pause();
+        _exit(EXIT_SUCCESS);
+    }
+    kill(pid, SIGSTOP);
+    assert(waitpid(pid, NULL, WUNTRACED) == pid);
+    assert(procfs_stat(pid, &state, &cpu_time));
+    assert(state == 'T');
+    long voluntary = -1, involuntary = -1;
+    assert(procfs_switches(pid, &voluntary, &involuntary));
+    assert(voluntary >= 0 && involuntary >= 0);
+    kill(pid, SIGKILL);
+    assert(waitpid(pid, NULL, 0) == pid);
+    assert(!procfs_stat(pid, &state, &cpu_time));
+    assert(!procfs_statm(pid, &rss));
+    assert(!procfs_switches(pid, &voluntary, &involuntary));
+
+    free(ballast);
+    return EXIT_SUCCESS;
+}
+
+int test_01_procfs_system() {
+    size_t available = 0;
+    Time   first = -1, second = -1;
+
+    assert(procfs_available(&available));
+    assert(available > 0);
+
+    /* Pressure stall totals only grow (and are missing without PSI) */
+    if (procfs_pressure("cpu", &first)) {
+        assert(procfs_pressure("cpu", &second));
+        assert(first >= 0 && second >= first);
+    }
+    assert(!procfs_pressure("nothing", &first));
+    return EXIT_SUCCESS;
+}
+
+int test_02_scheduler_admit() {
+    Scheduler s = { .policy = FIFO_POLICY, .cores = 2, .memory_limit = 0.10, .launch = LAUNCH_SIMULATE };
+    assert(scheduler_init(&s));
+    assert(s.limit == 2);
+
+    for (size_t i = 0; i < 16; i++) {
+        assert(scheduler_add(&s, NULL, "job"));
+    }
+    scheduler_next(&s);
+    assert(s.running.size == 2);
+
+    /* I/O bound jobs leave cores idle: limit grows one job per sample */
+    scheduler_admit_update(&s, 0, 0, 0.2, 0);
+    assert(s.limit == 3);
+    scheduler_next(&s);
+    assert(s.running.size == 3);
+    for (size_t i = 0; i < 10; i++) {
+        scheduler_admit_update(&s, 0, 0, 0.2, 0);
+        scheduler_next(&s);
+    }
+    assert(s.limit == 2 * ADMIT_SCALE && s.running.size == 2 * ADMIT_SCALE);
+
+    /* CPU pressure shrinks it back (running jobs are not stopped) */
+    scheduler_admit_update(&s, 0, 0.5, 1.9, 0);
+    assert(s.limit == 2 * ADMIT_SCALE - 1);
+    scheduler_admit_update(&s, 0, 0, 2.5, 0);
+    assert(s.limit == 2 * ADMIT_SCALE - 2);
+
+    /* Memory pressure holds waiting jobs */
+    while (s.running.size > 4) {
+        scheduler_exit(&s, s.running.head, 0, NULL);
+    }
+    scheduler_admit_update(&s, 0.5, 0, 1.0, 0);
+    assert(s.limit == 4 && s.holds == 1);
+    scheduler_exit(&s, s.running.head, 0, NULL);
+    scheduler_admit_update(&s, 0.5, 0, 1.0, 0);
+    scheduler_next(&s);
+    assert(s.running.size == 3 && s.limit == 3);
+
+    /* Too little memory for another job of the usual size holds too */
+    s.job_rss = 100 << 20;
+    scheduler_admit_update(&s, 0, 0, 1.0, 150 << 20);
+    assert(s.holds == 3);
+    scheduler_admit_update(&s, 0, 0, 1.0, 1 << 30);
+    assert(s.holds == 3);
+
+    /* Never below one */
+    while (s.running.size) {
+        scheduler_exit(&s, s.running.head, 0, NULL);
+    }
+    scheduler_admit_update(&s, 0.5, 0, 0, 0);
+    assert(s.limit == 1);
+    scheduler_admit_update(&s, 0, 0, 0, 0);
+    assert(s.limit == 2);
+
+    scheduler_release(&s);
+    return EXIT_SUCCESS;
+}
+
+int test_03_scheduler_switch() {
+    Scheduler s = { .policy = RDRN_POLICY, .cores = 1, .timeout = 250000, .launch = LAUNCH_SPAWN, .instrument = true };
+    assert(scheduler_init(&s));
+
+    Process *a = scheduler_add(&s, NULL, "sleep 10");
+    Process *b = scheduler_add(&s, NULL, "sleep 10");
+    assert(a && b);
+
+    /* Each stop is reaped after the pause returns; each resume is timed */
+    scheduler_next(&s);
+    scheduler_next(&s);
+    assert(s.running.head == b && s.preemptions == 1);
+    assert(a->stop_time && !s.stop_latency.count && !s.stop_timeouts);
+    for (int i = 0; i < 1000 && a->stop_time; i++) {
+        scheduler_wait(&s);
+        usleep(1000);
+    }
+    assert(!a->stop_time && s.stop_latency.count + s.stop_timeouts == 1);
+    assert(s.stop_latency.count == 0 || s.stop_latency.max < STOP_LIMIT + NSEC_PER_SEC);
+    assert(s.voluntary_switches >= 1 && a->voluntary_switches == s.voluntary_switches);
+    assert(s.resume_latency.count == 0);
+    scheduler_next(&s);
+    assert(s.running.head == a && s.preemptions == 2);
+    assert(s.resume_latency.count == 1 && s.dispatches == 3);
+
+    /* Exit accounts switches since the last sample */
+    kill(a->pid, SIGKILL);
+    kill(b->pid, SIGKILL);
+    while (s.finished.size < 2) {
+        scheduler_wait(&s);
+        usleep(1000);
+    }
+    assert(s.voluntary_switches == a->voluntary_switches + b->voluntary_switches);
+    assert(s.involuntary_switches == a->involuntary_switches + b->involuntary_switches);
+
+    scheduler_release(&s);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test procfs_process\n");
+	fprintf(stderr, "    1. Test procfs_system\n");
+	fprintf(stderr, "    2. Test scheduler_admit\n");
+	fprintf(stderr, "    3. Test scheduler_switch\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_procfs_process(); break;
+	case 1:	status = test_01_procfs_system(); break;
+	case 2:	status = test_02_scheduler_admit(); break;
+	case 3:	status = test_03_scheduler_switch(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
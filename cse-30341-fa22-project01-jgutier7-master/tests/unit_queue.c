@@ -8,11 +8,11 @@
 /* Constants */
 
 Process PROCESSES[] = {
-    { "1", 1 },
-    { "2", 2 },
-    { "3", 3 },
-    { "4", 4 },
-    { "0", 0 },
+    { .command = "1", .pid = 1 },
+    { .command = "2", .pid = 2 },
+    { .command = "3", .pid = 3 },
+    { .command = "4", .pid = 4 },
+    { .command = "0", .pid = 0 },
 };
 
 /* Test cases */
@@ -79,6 +79,35 @@ int test_02_queue_remove() {
     return EXIT_SUCCESS;
 }
 
+int test_03_queue_unlink() {
+    Queue q = {0};
+    size_t i;
+
+    for (i = 0; PROCESSES[i].pid; i++) {
+    	queue_push(&q, &PROCESSES[i]);
+    	assert(PROCESSES[i].queue == &q);
+    }
+
+    /* Middle, tail, then head */
+    queue_unlink(&PROCESSES[1]);
+    assert(q.size == i - 1 && !PROCESSES[1].queue);
+    assert(PROCESSES[0].next == &PROCESSES[2] && PROCESSES[2].prev == &PROCESSES[0]);
+
+    queue_unlink(&PROCESSES[3]);
+    assert(q.tail == &PROCESSES[2] && !PROCESSES[2].next);
+
+    queue_unlink(&PROCESSES[0]);
+    assert(q.head == &PROCESSES[2] && !PROCESSES[2].prev);
+
+    queue_unlink(&PROCESSES[0]);
+    assert(q.size == 1);
+
+    assert(queue_pop(&q) == &PROCESSES[2]);
+    assert(!q.head && !q.tail && !q.size);
+
+    return EXIT_SUCCESS;
+}
+
 /* Main execution */
 
 int main(int argc, char *argv[]) {
@@ -88,6 +117,7 @@ int main(int argc, char *argv[]) {
 	fprintf(stderr, "    0. Test queue_push\n");
 	fprintf(stderr, "    1. Test queue_pop\n");
 	fprintf(stderr, "    2. Test queue_remove\n");
+	fprintf(stderr, "    3. Test queue_unlink\n");
 	return EXIT_FAILURE;
     }
 
@@ -98,6 +128,7 @@ int main(int argc, char *argv[]) {
 	case 0:	status = test_00_queue_push(); break;
 	case 1:	status = test_01_queue_pop(); break;
 	case 2:	status = test_02_queue_remove(); break;
+	case 3:	status = test_03_queue_unlink(); break;
 	default:
 	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
 	    break;
@@ -0,0 +1,124 @@
+/* unit_rbtree.c: Test PQSH Red-Black Tree */
+
+#include "pqsh/macros.h"
+#include "pqsh/rbtree.h"
+
+#include <assert.h>
+
+/* Constants */
+
+#define NITEMS  1000
+
+/* Structures */
+
+typedef struct {
+    int     key;
+    RBNode  node;
+} Item;
+
+Item ITEMS[NITEMS];
+
+/* Functions */
+
+int compare(const RBNode *a, const RBNode *b) {
+    return container_of(a, Item, node)->key - container_of(b, Item, node)->key;
+}
+
+/* Return black height of subtree (asserting red-black properties) */
+int check(RBNode *n) {
+    if (!n) {
+        return 1;
+    }
+
+    if (n->red) {
+        assert(!n->left  || !n->left->red);
+        assert(!n->right || !n->right->red);
+    }
+    if (n->left)  assert(n->left->parent == n && compare(n->left, n) <= 0);
+    if (n->right) assert(n->right->parent == n && compare(n->right, n) >= 0);
+
+    int left  = check(n->left);
+    int right = check(n->right);
+    assert(left == right);
+    return left + !n->red;
+}
+
+void populate(RBTree *t) {
+    for (int i = 0; i < NITEMS; i++) {
+        ITEMS[i].key = (i * 7919) % NITEMS;
+        rbtree_insert(t, &ITEMS[i].node, compare);
+    }
+}
+
+/* Test cases */
+
+int test_00_rbtree_insert() {
+    RBTree t = {0};
+    populate(&t);
+
+    assert(t.size == NITEMS);
+    assert(!t.root->red);
+    check(t.root);
+
+    int previous = -1;
+    for (RBNode *n = rbtree_first(&t); n; n = rbtree_next(n)) {
+        assert(container_of(n, Item, node)->key == previous + 1);
+        previous++;
+    }
+    assert(previous == NITEMS - 1);
+    assert(container_of(rbtree_last(&t), Item, node)->key == NITEMS - 1);
+
+    return EXIT_SUCCESS;
+}
+
+int test_01_rbtree_remove() {
+    RBTree t = {0};
+    populate(&t);
+
+    /* Remove every other item in insertion order */
+    for (int i = 0; i < NITEMS; i += 2) {
+        rbtree_remove(&t, &ITEMS[i].node);
+        check(t.root);
+    }
+    assert(t.size == NITEMS / 2);
+
+    /* Drain from the front */
+    int previous = -1;
+    while (t.size) {
+        RBNode *n = rbtree_first(&t);
+        assert(container_of(n, Item, node)->key > previous);
+        previous = container_of(n, Item, node)->key;
+        rbtree_remove(&t, n);
+        check(t.root);
+    }
+    assert(t.root == NULL && rbtree_first(&t) == NULL);
+
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test rbtree_insert\n");
+	fprintf(stderr, "    1. Test rbtree_remove\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_rbtree_insert(); break;
+	case 1:	status = test_01_rbtree_remove(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,410 @@
+/* unit_simulator.c: Test PQSH Discrete-Event Simulator */
+
+#include "pqsh/macros.h"
+#include "pqsh/simulator.h"
+
+#include <assert.h>
+#include <math.h>
+
+/* Constants */
+
+const char *TRACE =
+    "# arrival burst io_period io_time command\n"
+    "0 2 0 0 a\n"
+    "\n"
+    "1 1\n"
+    "0 2 0 0 b\n";
+
+/* Functions */
+
+/* Whether or not values are equal within rounding */
+int equal(double a, double b) {
+    return a - b < 1e-6 && b - a < 1e-6;
+}
+
+/* Simulate trace with configured scheduler */
+Scheduler *simulate_scheduler(const char *trace, Scheduler *s) {
+    Simulator sim = {0};
+
+    assert(scheduler_init(s));
+
+    FILE *fs = fmemopen((void *)trace, strlen(trace), "r");
+    assert(fs);
+    assert(simulator_load(&sim, fs));
+    fclose(fs);
+
+    assert(simulator_run(&sim, s));
+    assert(s->finished.size == sim.size);
+    simulator_release(&sim);
+    return s;
+}
+
+/* Simulate trace with policy on cores with 250 ms time slices */
+Scheduler *simulate_cores(const char *trace, Policy policy, size_t cores, bool swap) {
+    static Scheduler s;
+
+    s = (Scheduler) {
+        .policy        = policy,
+        .cores         = cores,
+        .timeout       = 250000,
+        .launch        = LAUNCH_SIMULATE,
+        .levels        = 3,
+        .swap_sleeping = swap,
+    };
+    return simulate_scheduler(trace, &s);
+}
+
+/* Simulate trace with policy on a single core with 250 ms time slices */
+Scheduler *simulate(const char *trace, Policy policy) {
+    return simulate_cores(trace, policy, 1, false);
+}
+
+/* Test cases */
+
+int test_00_simulator_load() {
+    Simulator sim = {0};
+    FILE *fs = fmemopen((void *)TRACE, strlen(TRACE), "r");
+    assert(fs);
+    assert(simulator_load(&sim, fs));
+    fclose(fs);
+
+    /* Sorted by arrival, ties in trace order */
+    assert(sim.size == 3);
+    assert(streq(sim.jobs[0].command, "a") && equal(sim.jobs[0].burst, 2));
+    assert(streq(sim.jobs[1].command, "b"));
+    assert(streq(sim.jobs[2].command, "job") && equal(sim.jobs[2].arrival, 1));
+    simulator_release(&sim);
+
+    const char *invalid = "0 1 2\n";
+    fs = fmemopen((void *)invalid, strlen(invalid), "r");
+    assert(!simulator_load(&sim, fs));
+    fclose(fs);
+    simulator_release(&sim);
+    return EXIT_SUCCESS;
+}
+
+int test_01_simulator_fifo() {
+    Scheduler *s = simulate(TRACE, FIFO_POLICY);
+
+    /* a: 0-2, b: 2-4, job: 4-5 */
+    assert(equal(time_to_seconds(histogram_mean(&s->turnaround)), (2 + 4 + 4) / 3.0));
+    assert(equal(time_to_seconds(histogram_mean(&s->response)),   (0 + 2 + 3) / 3.0));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 5));
+
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_02_simulator_rdrn() {
+    const char *trace = "0 1 0 0 a\n0 1 0 0 b\n";
+    Scheduler  *s     = simulate(trace, RDRN_POLICY);
+
+    /* Alternating 250 ms slices: a ends at 1.75, b at 2.00 */
+    assert(equal(time_to_seconds(histogram_mean(&s->turnaround)), (1.75 + 2.0) / 2));
+    assert(equal(time_to_seconds(histogram_mean(&s->response)),   (0 + 0.25) / 2));
+
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_03_simulator_io() {
+    /* I/O completes while the job is paused, so it overlaps with b */
+    const char *trace = "0 1 0.5 1 a\n0 0.5 0 0 b\n";
+    Scheduler  *s     = simulate(trace, FIFO_POLICY);
+
+    /* a: cpu 0-0.5, I/O 0.5-1.5 (still holding the core), cpu 1.5-2.0; b: 2.0-2.5 */
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 2.0));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 2.5));
+
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_04_simulator_swap() {
+    /* b and c compute on two cores while a waits on I/O from 0.01 to 2.01 */
+    const char *trace = "0 1 0 0 b\n0 0.02 0.01 2 a\n0 1 0 0 c\n";
+
+    /* Plain round robin: a holds a core every other slice */
+    Scheduler *s = simulate_cores(trace, RDRN_POLICY, 2, false);
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 1.5));
+    assert(equal(time_to_seconds(s->finished.head->next->end_time), SIMULATOR_EPOCH + 1.5));
+    assert(s->sleep_swaps == 0);
+    scheduler_release(s);
+
+    /* Swapped out at the first tick it sleeps through, so b finishes a slice earlier */
+    s = simulate_cores(trace, RDRN_POLICY, 2, true);
+    assert(streq(s->finished.head->command, "b"));
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 1.25));
+    assert(equal(time_to_seconds(s->finished.head->next->end_time), SIMULATOR_EPOCH + 1.5));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 2.02));
+    assert(s->sleep_swaps == 3);
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_05_simulator_share() {
+    /* team holds 75% of the tickets, so its 10 s finish near 13.33 s */
+    const char *trace = "0 10 0 0 -t 300 -- team\n0 10 0 0 other\n";
+
+    Scheduler *s = simulate(trace, STRIDE_POLICY);
+    assert(streq(s->finished.head->command, "team"));
+    assert(fabs(time_to_seconds(s->finished.head->end_time) - (SIMULATOR_EPOCH + 13.33)) <= 0.25);
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 20));
+    scheduler_release(s);
+
+    /* Lottery only converges on the same share */
+    s = simulate(trace, LOTTERY_POLICY);
+    assert(streq(s->finished.head->command, "team"));
+    assert(fabs(time_to_seconds(s->finished.head->end_time) - (SIMULATOR_EPOCH + 13.33)) <= 3);
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 20));
+    assert(!s->lottery.size && !s->lottery.total);
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_06_simulator_edf() {
+    /* urgent arrives during relaxed with the earliest deadline (1.5 s) */
+    const char *trace = "0 2 0 0 a\n0 1 0 0 --deadline 5 -- relaxed\n0.5 1 0 0 --deadline 1 -- urgent\n";
+
+    Scheduler *s = simulate(trace, EDF_POLICY);
+    assert(streq(s->finished.head->command, "urgent"));
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 1.5));
+    assert(equal(time_to_seconds(s->finished.head->next->end_time), SIMULATOR_EPOCH + 2));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 4));
+    assert(s->deadlines == 2 && s->deadline_misses == 0);
+    assert(s->lateness.max == 0);
+    scheduler_release(s);
+
+    /* Arrival order misses it by 2.5 s */
+    s = simulate(trace, FIFO_POLICY);
+    assert(streq(s->finished.tail->command, "urgent"));
+    assert(s->deadlines == 2 && s->deadline_misses == 1);
+    assert(equal(time_to_seconds(s->lateness.max), 2.5));
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_07_simulator_fair() {
+    /* flood submits 20 jobs before report's 6 on 4 cores */
+    char trace[BUFSIZ] = "";
+    for (int i = 0; i < 20; i++) strcat(trace, "0 1 0 0 --tenant flood -- flood\n");
+    for (int i = 0; i < 6; i++)  strcat(trace, "0 1 0 0 --tenant report -- report\n");
+
+    /* Arrival order: report waits for every flood job */
+    Scheduler *s = simulate_cores(trace, FIFO_POLICY, 4, false);
+    assert(streq(s->finished.tail->command, "report"));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 7));
+    scheduler_release(s);
+
+    /* Fair share at 3:1 gives report 3 cores from the first tick */
+    static Scheduler fair;
+    fair = (Scheduler) { .policy = FAIR_POLICY, .cores = 4, .timeout = 250000, .launch = LAUNCH_SIMULATE };
+    assert(scheduler_tenant_config(&fair, "report:3:rdrn"));
+    assert(!scheduler_tenant_config(&fair, "bad:0"));
+    assert(!scheduler_tenant_config(&fair, "bad:1:mlfq"));
+    s = simulate_scheduler(trace, &fair);
+
+    Time report = 0, flood = 0;
+    for (Process *p = s->finished.head; p; p = p->next) {
+        if (streq(p->command, "report")) {
+            assert(streq(p->tenant->name, "report"));
+            report = max(report, p->end_time);
+        } else {
+            flood  = max(flood, p->end_time);
+        }
+    }
+    assert(time_to_seconds(report) <= SIMULATOR_EPOCH + 2.25 + 1e-6);
+    assert(equal(time_to_seconds(flood), SIMULATOR_EPOCH + 7));           // work conserving
+    assert(s->tenants[0]->weight == 3 && s->tenants[0]->finished == 6);
+    assert(s->tenants[1]->finished == 20);
+
+    /* Rejected jobs do not create tenants */
+    assert(!scheduler_add(s, NULL, "--tenant ghost -w 0 ghost"));
+    assert(s->ntenants == 2);
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_08_simulator_mlfq() {
+    /* long is demoted after its 250 ms slice at level 0 and yields to short */
+    Scheduler *s = simulate("0 2 0 0 long\n0 0.25 0 0 short\n", MLFQ_POLICY);
+    assert(streq(s->finished.head->command, "short"));
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 0.5));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 2.25));
+    assert(s->finished.tail->level == 2 && s->preemptions == 1);        // alone, it keeps its core
+    scheduler_release(s);
+
+    /* short arrives while long runs at level 2 and takes its core at the next tick */
+    s = simulate("0 3 0 0 long\n1.1 0.1 0 0 short\n", MLFQ_POLICY);
+    assert(streq(s->finished.head->command, "short"));
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 1.35));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 3.1));
+    assert(s->preemptions == 1);
+    scheduler_release(s);
+
+    /* One waiting job only takes one of the two expired cores */
+    s = simulate_cores("0 1 0 0 a\n0 1 0 0 b\n0 1 0 0 c\n", MLFQ_POLICY, 2, false);
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 1.5));
+    assert(s->preemptions == 4);
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_09_simulator_boost() {
+    /* Boosts every second start a new level 0 slice instead of demoting the running job */
+    static Scheduler boost;
+    boost = (Scheduler) { .policy = MLFQ_POLICY, .cores = 1, .timeout = 250000, .launch = LAUNCH_SIMULATE, .levels = 3, .boost = 1000000 };
+    Scheduler *s = simulate_scheduler("0 3 0 0 a\n0 3 0 0 b\n", &boost);
+    assert(streq(s->finished.head->command, "a"));
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 4));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 6));
+    assert(s->preemptions == 8);
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_10_simulator_cfs() {
+    /* heavy has twice the weight, so it gets 2/3 of the core while both run */
+    Scheduler *s = simulate("0 4 0 0 -w 2 -- heavy\n0 4 0 0 light\n", CFS_POLICY);
+    assert(streq(s->finished.head->command, "heavy"));
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 6));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 8));
+    scheduler_release(s);
+
+    /* late starts at the minimum virtual runtime and shares the core (from
+     * zero it would run alone until 3.0) */
+    s = simulate("0 4 0 0 a\n0 4 0 0 b\n2 1 0 0 late\n", CFS_POLICY);
+    assert(streq(s->finished.head->command, "late"));
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 4.5));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 9));
+    assert(!s->tree.size);
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+/* Return core of nth event of type for command in trace (-2 if none) */
+int trace_core(Trace *t, const char *command, TraceType type, size_t nth) {
+    for (size_t i = 0; i < t->count; i++) {
+        if (t->events[i].type == type && streq(t->events[i].command, command) && nth-- == 0) {
+            return t->events[i].core;
+        }
+    }
+    return -2;
+}
+
+/* Simulate trace with round robin on two cores with per-core run queues */
+Scheduler *simulate_affinity(const char *trace) {
+    static Scheduler s;
+
+    s = (Scheduler) { .policy = RDRN_POLICY, .cores = 2, .timeout = 250000, .launch = LAUNCH_SIMULATE, .affinity = true };
+    assert(trace_init(&s.trace, 1024));
+    return simulate_scheduler(trace, &s);
+}
+
+/* Simulate trace with shortest remaining time first and learned run times */
+Scheduler *simulate_srtf(const char *trace, double hog, double short_) {
+    static Scheduler s;
+
+    s = (Scheduler) { .policy = SRTF_POLICY, .cores = 1, .timeout = 250000, .launch = LAUNCH_SIMULATE };
+    assert(history_update(&s.history, "hog", hog));
+    assert(history_update(&s.history, "short", short_));
+    return simulate_scheduler(trace, &s);
+}
+
+int test_11_simulator_srtf() {
+    /* short arrives behind hog and takes its core right away */
+    const char *trace = "0 4 0 0 hog\n1.1 0.5 0 0 short\n";
+    Scheduler  *s     = simulate_srtf(trace, 4, 0.5);
+    assert(streq(s->finished.head->command, "short"));
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 1.6));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 4.5));
+    assert(s->preemptions == 1);
+    scheduler_release(s);
+
+    /* hog overruns its 1 s estimate and is re-estimated to twice the time it
+     * has used, so short still preempts it instead of waiting until 4.0 */
+    trace = "0 4 0 0 hog\n2.1 1 0 0 short\n";
+    s     = simulate_srtf(trace, 1, 1);
+    assert(streq(s->finished.head->command, "short"));
+    assert(equal(time_to_seconds(s->finished.head->end_time), SIMULATOR_EPOCH + 3.1));
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 5));
+    assert(s->finished.tail->estimate >= time_from_seconds(4));
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+int test_12_simulator_affinity() {
+    /* b's core is idle when c and d are placed at 0.25, so c goes there and
+     * d queues behind a, which keeps resuming on core 0 */
+    Scheduler *s = simulate_affinity("0 1 0 0 a\n0 0.25 0 0 b\n0 1 0 0 c\n0 0.25 0 0 d\n");
+    assert(trace_core(&s->trace, "a", TRACE_START, 0) == 0);
+    assert(trace_core(&s->trace, "b", TRACE_START, 0) == 1);
+    assert(trace_core(&s->trace, "c", TRACE_START, 0) == 1);
+    assert(trace_core(&s->trace, "d", TRACE_START, 0) == 0);
+    assert(trace_core(&s->trace, "a", TRACE_RESUME, 0) == 0);
+    assert(trace_core(&s->trace, "a", TRACE_RESUME, 1) == -2);
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 1.25));
+    scheduler_release(s);
+
+    /* a and c share core 0 until b leaves core 1 idle at 1.0, which then
+     * steals a from core 0's run queue */
+    s = simulate_affinity("0 1 0 0 a\n0 1 0 0 b\n0 1 0 0 c\n");
+    assert(trace_core(&s->trace, "c", TRACE_START, 0) == 0);
+    assert(trace_core(&s->trace, "a", TRACE_RESUME, 0) == 0);
+    assert(trace_core(&s->trace, "c", TRACE_RESUME, 0) == 0);
+    assert(trace_core(&s->trace, "a", TRACE_RESUME, 1) == 1);
+    assert(trace_core(&s->trace, "a", TRACE_EXIT, 0) == 1);
+    assert(equal(time_to_seconds(s->finished.tail->end_time), SIMULATOR_EPOCH + 1.5));
+    assert(!s->runqueues[0].size && !s->runqueues[1].size);
+    scheduler_release(s);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test simulator_load\n");
+	fprintf(stderr, "    1. Test simulator_fifo\n");
+	fprintf(stderr, "    2. Test simulator_rdrn\n");
+	fprintf(stderr, "    3. Test simulator_io\n");
+	fprintf(stderr, "    4. Test simulator_swap\n");
+	fprintf(stderr, "    5. Test simulator_share\n");
+	fprintf(stderr, "    6. Test simulator_edf\n");
+	fprintf(stderr, "    7. Test simulator_fair\n");
+	fprintf(stderr, "    8. Test simulator_mlfq\n");
+	fprintf(stderr, "    9. Test simulator_boost\n");
+	fprintf(stderr, "    10. Test simulator_cfs\n");
+	fprintf(stderr, "    11. Test simulator_srtf\n");
+	fprintf(stderr, "    12. Test simulator_affinity\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_simulator_load(); break;
+	case 1:	status = test_01_simulator_fifo(); break;
+	case 2:	status = test_02_simulator_rdrn(); break;
+	case 3:	status = test_03_simulator_io(); break;
+	case 4:	status = test_04_simulator_swap(); break;
+	case 5:	status = test_05_simulator_share(); break;
+	case 6:	status = test_06_simulator_edf(); break;
+	case 7:	status = test_07_simulator_fair(); break;
+	case 8:	status = test_08_simulator_mlfq(); break;
+	case 9:	status = test_09_simulator_boost(); break;
+	case 10: status = test_10_simulator_cfs(); break;
+	case 11: status = test_11_simulator_srtf(); break;
+	case 12: status = test_12_simulator_affinity(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
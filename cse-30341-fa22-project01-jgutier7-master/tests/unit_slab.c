@@ -0,0 +1,108 @@
+/* unit_slab.c: Test PQSH Slab Allocator */
+
+#include "pqsh/macros.h"
+#include "pqsh/slab.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+/* Constants */
+
+#define NOBJECTS    10000
+
+/* Structures */
+
+typedef struct {
+    double  value;
+    char    name[40];
+} Object;
+
+Object *OBJECTS[NOBJECTS];
+
+/* Test cases */
+
+int test_00_slab_alloc() {
+    Slab s = SLAB_INITIALIZER(Object);
+
+    assert(s.size % SLAB_ALIGN == 0);
+    for (size_t i = 0; i < NOBJECTS; i++) {
+        OBJECTS[i] = slab_alloc(&s);
+        assert(OBJECTS[i]);
+        assert(((uintptr_t)OBJECTS[i]) % SLAB_ALIGN == 0);
+        assert(OBJECTS[i]->value == 0 && !OBJECTS[i]->name[0]);
+        OBJECTS[i]->value = i;
+        snprintf(OBJECTS[i]->name, sizeof(OBJECTS[i]->name), "%lu", i);
+    }
+
+    assert(s.used == NOBJECTS);
+    assert(s.capacity >= NOBJECTS);
+    for (size_t i = 0; i < NOBJECTS; i++) {
+        assert(OBJECTS[i]->value == i);
+        assert((size_t)atoi(OBJECTS[i]->name) == i);
+    }
+
+    slab_release(&s);
+    assert(!s.chunks && !s.used && !s.capacity);
+    return EXIT_SUCCESS;
+}
+
+int test_01_slab_free() {
+    Slab s = SLAB_INITIALIZER(Object);
+
+    for (size_t i = 0; i < NOBJECTS; i++) {
+        OBJECTS[i] = slab_alloc(&s);
+    }
+    size_t capacity = s.capacity;
+
+    /* Freed objects are reused before the slab grows */
+    for (size_t i = 0; i < NOBJECTS; i += 2) {
+        slab_free(&s, OBJECTS[i]);
+    }
+    assert(s.used == NOBJECTS / 2);
+    for (size_t i = 0; i < NOBJECTS; i += 2) {
+        OBJECTS[i] = slab_alloc(&s);
+        assert(OBJECTS[i]->value == 0);
+    }
+    assert(s.capacity == capacity);
+
+    /* Freeing the last object keeps the chunks until trimmed */
+    assert(!slab_trim(&s));
+    for (size_t i = 0; i < NOBJECTS; i++) {
+        slab_free(&s, OBJECTS[i]);
+    }
+    assert(!s.used && s.capacity == capacity);
+    OBJECTS[0] = slab_alloc(&s);
+    assert(s.capacity == capacity);
+    slab_free(&s, OBJECTS[0]);
+
+    assert(slab_trim(&s));
+    assert(!s.chunks && !s.used && !s.capacity);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test slab_alloc\n");
+	fprintf(stderr, "    1. Test slab_free\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_slab_alloc(); break;
+	case 1:	status = test_01_slab_free(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
@@ -0,0 +1,119 @@
+/* unit_slice.c: Test PQSH Adaptive Time Slice */
+
+#include "pqsh/macros.h"
+#include "pqsh/scheduler.h"
+
+#include <assert.h>
+
+/* Functions */
+
+/* Round robin scheduler with 250 ms ceiling and given overhead target */
+Scheduler *scheduler_create(double overhead) {
+    Scheduler *s = calloc(1, sizeof(Scheduler));
+    assert(s);
+
+    s->policy   = RDRN_POLICY;
+    s->cores    = 1;
+    s->timeout  = 250000;
+    s->overhead = overhead;
+    assert(scheduler_init(s));
+    return s;
+}
+
+void scheduler_delete(Scheduler *s) {
+    scheduler_release(s);
+    free(s);
+}
+
+/* Test cases */
+
+int test_00_scheduler_slice_bursts() {
+    Scheduler *s = scheduler_create(0.05);
+
+    /* Fixed until enough bursts are seen */
+    assert(scheduler_slice(s) == 250000);
+    for (size_t i = 0; i < SLICE_SAMPLES - 1; i++) {
+        scheduler_slice_burst(s, time_from_seconds(0.010));
+    }
+    assert(scheduler_slice(s) == 250000);
+
+    /* Short jobs shrink the slice to fit them */
+    scheduler_slice_burst(s, time_from_seconds(0.010));
+    time_t slice = scheduler_slice(s);
+    assert(slice >= 10000 && slice < 10200);
+
+    /* Small changes do not move the slice */
+    for (size_t i = 0; i < SLICE_SAMPLES; i++) {
+        scheduler_slice_burst(s, time_from_seconds(0.0105));
+    }
+    assert(scheduler_slice(s) == slice);
+
+    /* Long jobs grow it back, but never past the timeout */
+    for (size_t i = 0; i < SLICE_WINDOW * 2; i++) {
+        scheduler_slice_burst(s, time_from_seconds(10.0));
+    }
+    assert(s->bursts.count < SLICE_WINDOW);
+    assert(scheduler_slice(s) == 250000);
+
+    scheduler_delete(s);
+    return EXIT_SUCCESS;
+}
+
+int test_01_scheduler_slice_cost() {
+    Scheduler *s = scheduler_create(0.10);
+
+    for (size_t i = 0; i < SLICE_SAMPLES; i++) {
+        scheduler_slice_burst(s, time_from_seconds(0.0001));
+    }
+    assert(scheduler_slice(s) == SLICE_MIN);
+
+    /* 1 ms per preemption at 10% overhead needs a 9 ms slice */
+    scheduler_slice_cost(s, time_from_seconds(0.001));
+    assert(s->switch_cost == NSEC_PER_MSEC);
+    time_t slice = scheduler_slice(s);
+    assert(slice >= 8990 && slice <= 9010);
+
+    /* Cost is smoothed */
+    scheduler_slice_cost(s, time_from_seconds(0.009));
+    assert(s->switch_cost > NSEC_PER_MSEC && s->switch_cost < 9 * NSEC_PER_MSEC);
+
+    /* Overhead target wins over timeout */
+    for (size_t i = 0; i < 64; i++) {
+        scheduler_slice_cost(s, time_from_seconds(0.1));
+    }
+    assert(scheduler_slice(s) > 250000);
+
+    /* Fixed slice without target */
+    s->overhead = 0;
+    assert(scheduler_slice(s) == 250000);
+
+    scheduler_delete(s);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test scheduler_slice_bursts\n");
+	fprintf(stderr, "    1. Test scheduler_slice_cost\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_scheduler_slice_bursts(); break;
+	case 1:	status = test_01_scheduler_slice_cost(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */
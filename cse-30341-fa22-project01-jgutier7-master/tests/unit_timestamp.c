@@ -12,11 +12,58 @@
 int test_00_timestamp() {
     for (int i = 0; i < 10; i++) {
     	double time_0 = time(NULL);
-    	double time_1 = timestamp();
+    	double time_1 = timestamp_wall(timestamp());
     	double time_d = time_1 - time_0;
 
     	assert(time_1 > 0);
-    	assert(0.0 < time_d && time_d < 1.0);
+    	assert(0.0 <= time_d && time_d < 1.0);
+    }
+
+    /* Wall clock round trip (0 means never) */
+    Time now = timestamp();
+    assert(llabs(timestamp_from_wall(timestamp_wall(now)) - now) < NSEC_PER_USEC);
+    assert(timestamp_wall(0) == 0 && timestamp_from_wall(0) == 0);
+    return EXIT_SUCCESS;
+}
+
+int test_01_timestamp_monotonic() {
+    /* Never runs backwards and resolves below a microsecond */
+    Time last     = timestamp();
+    Time smallest = NSEC_PER_SEC;
+    for (int i = 0; i < 100000; i++) {
+        Time now = timestamp();
+        assert(now >= last);
+        if (now > last) {
+            smallest = min(smallest, now - last);
+        }
+        last = now;
+    }
+    assert(smallest < NSEC_PER_USEC);
+
+    /* Virtual clock overrides until reset */
+    timestamp_virtual(time_from_seconds(1.5));
+    assert(timestamp() == 1500000000);
+    timestamp_virtual(0);
+    assert(timestamp() >= last);
+
+    assert(time_from_seconds(0.000000001) == 1);
+    assert(time_to_seconds(NSEC_PER_SEC / 4) == 0.25);
+    return EXIT_SUCCESS;
+}
+
+int test_02_timestamp_tsc() {
+    if (!timestamp_tsc()) {
+        return EXIT_SUCCESS;                                        // no invariant TSC
+    }
+
+    /* Calibrated TSC agrees with CLOCK_MONOTONIC */
+    struct timespec ts;
+    for (int i = 0; i < 10; i++) {
+        Time before = timestamp();
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        Time clock  = ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+        assert(llabs(clock - before) < NSEC_PER_SEC / 1000);
+        assert(timestamp() >= before);
     }
     return EXIT_SUCCESS;
 }
@@ -28,6 +75,8 @@ int main(int argc, char *argv[]) {
 	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
 	fprintf(stderr, "Where NUMBER is right of the following:\n");
 	fprintf(stderr, "    0  Test timestamp\n");
+	fprintf(stderr, "    1  Test timestamp_monotonic\n");
+	fprintf(stderr, "    2  Test timestamp_tsc\n");
 	return EXIT_FAILURE;
     }
 
@@ -36,6 +85,8 @@ int main(int argc, char *argv[]) {
 
     switch (number) {
 	case 0:	status = test_00_timestamp(); break;
+	case 1:	status = test_01_timestamp_monotonic(); break;
+	case 2:	status = test_02_timestamp_tsc(); break;
 	default:
 	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
 	    break;
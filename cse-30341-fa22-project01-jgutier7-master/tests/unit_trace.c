@@ -0,0 +1,114 @@
+/* unit_trace.c: Test PQSH Scheduling Trace */
+
+#include "pqsh/macros.h"
+#include "pqsh/trace.h"
+
+#include <assert.h>
+#include <unistd.h>
+
+/* Constants */
+
+#define CAPACITY    4
+#define NEVENTS     10
+
+const char *TRACE_PATH = "/tmp/unit_trace.json";
+
+/* Functions */
+
+/* Count occurrences of needle in file */
+size_t count(const char *path, const char *needle) {
+    char   buffer[BUFSIZ];
+    size_t n  = 0;
+    FILE  *fs = fopen(path, "r");
+    assert(fs);
+
+    while (fgets(buffer, BUFSIZ, fs)) {
+        for (char *s = buffer; (s = strstr(s, needle)); s++) {
+            n++;
+        }
+    }
+    fclose(fs);
+    return n;
+}
+
+/* Test cases */
+
+int test_00_trace_record() {
+    Trace   t = {0};
+    Process p = { .command = "sleep 1", .pid = 1 };
+
+    /* Disabled trace ignores events */
+    trace_record(&t, TRACE_START, &p, 0, NSEC_PER_SEC);
+    assert(t.count == 0);
+
+    assert(trace_init(&t, CAPACITY));
+    for (size_t i = 0; i < NEVENTS; i++) {
+        p.pid = i;
+        trace_record(&t, i % 2 ? TRACE_PAUSE : TRACE_START, &p, 0, t.origin + i * NSEC_PER_SEC);
+    }
+
+    /* Only the newest events remain */
+    assert(t.count == NEVENTS);
+    for (size_t i = NEVENTS - CAPACITY; i < NEVENTS; i++) {
+        TraceEvent *e = &t.events[i % CAPACITY];
+        assert(e->pid == (int)i);
+        assert(e->type == (i % 2 ? TRACE_PAUSE : TRACE_START));
+        assert(streq(e->command, "sleep 1"));
+    }
+
+    trace_release(&t);
+    assert(!t.events && !t.count);
+    return EXIT_SUCCESS;
+}
+
+int test_01_trace_flush() {
+    Trace   t = {0};
+    Process p = { .command = "echo \"hi\"", .pid = 7 };
+
+    assert(trace_init(&t, CAPACITY));
+    trace_record(&t, TRACE_ARRIVAL, &p, -1, t.origin);
+    trace_record(&t, TRACE_START,   &p,  1, t.origin + time_from_seconds(0.001));
+    trace_record(&t, TRACE_PAUSE,   &p,  1, t.origin + time_from_seconds(0.002));
+    trace_record(&t, TRACE_RESUME,  &p,  0, t.origin + time_from_seconds(0.003));
+    trace_record(&t, TRACE_EXIT,    &p,  0, t.origin + time_from_seconds(0.004));
+    assert(trace_flush(&t, TRACE_PATH));
+
+    assert(count(TRACE_PATH, "\"dropped\": 1") == 1);
+    assert(count(TRACE_PATH, "\"name\": \"Core 0\"") == 1);
+    assert(count(TRACE_PATH, "\"name\": \"Core 1\"") == 1);
+    assert(count(TRACE_PATH, "\"ph\": \"B\"") == 2);
+    assert(count(TRACE_PATH, "\"ph\": \"E\"") == 2);
+    assert(count(TRACE_PATH, "\"ts\": ") == 4);
+    assert(count(TRACE_PATH, "echo \\\"hi\\\"") == 4);
+
+    unlink(TRACE_PATH);
+    trace_release(&t);
+    return EXIT_SUCCESS;
+}
+
+/* Main execution */
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s NUMBER\n\n", argv[0]);
+	fprintf(stderr, "Where NUMBER is right of the following:\n");
+	fprintf(stderr, "    0. Test trace_record\n");
+	fprintf(stderr, "    1. Test trace_flush\n");
+	return EXIT_FAILURE;
+    }
+
+    int number = atoi(argv[1]);
+    int status = EXIT_FAILURE;
+
+    switch (number) {
+	case 0:	status = test_00_trace_record(); break;
+	case 1:	status = test_01_trace_flush(); break;
+	default:
+	    fprintf(stderr, "Unknown NUMBER: %d\n", number);
+	    break;
+    }
+
+    return status;
+}
+
+/* vim: set expandtab sts=4 sw=4 ts=8 ft=c: */